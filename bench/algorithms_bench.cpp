@@ -0,0 +1,463 @@
+/**
+ * Scaling of the parallel algorithms against their sequential std:: versions.
+ *
+ * g++ -std=c++17 -O2 -pthread bench/algorithms_bench.cpp -o algorithms_bench
+ * ./algorithms_bench --min-size 1e3 --max-size 1e8 --threads 1,2,4,8 --json scaling.json
+ *
+ * For every algorithm, distribution, input size and thread count it prints
+ * the sequential and parallel times, speedup and efficiency (speedup / threads;
+ * n/a for algorithms that pick their own thread count).
+ * When perf_event_open is allowed the parallel run also reports cycles,
+ * instructions and cache misses summed over all of its threads, counted
+ * over the timed part of the repetitions only.
+ * The quicksorts take the first element as pivot, so sorted, reverse and
+ * duplicates input degenerate to O(n^2); they are capped by --sort-max and --degenerate-max.
+ * --placement compact|scatter|cores pins the worker threads and the caller (see ch8/topology.h).
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../ch2/parallelAcc.h"
+#include "../ch4/concurrencyQuickSort.h"
+#include "../ch8/parallel_accumulate.h"
+#include "../ch8/parallelQuickSort.h"
+
+using namespace std;
+
+typedef unsigned value_type;
+
+/**
+ * Hardware counters for the calling thread and every thread it spawns
+ * while enabled. Silently unavailable when the kernel refuses.
+ */
+class perf_counters {
+private:
+	struct counter {
+		char const* name;
+		uint32_t type;
+		uint64_t config;
+		int fd;
+	};
+	vector<counter> m_counters;
+
+public:
+	perf_counters() {
+		m_counters = {
+			{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1},
+			{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1},
+			{"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1},
+			{"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1},
+		};
+		for (auto& c : m_counters) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = c.type;
+			attr.config = c.config;
+			attr.disabled = 1;
+			attr.inherit = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			c.fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+	}
+	~perf_counters() {
+		for (auto& c : m_counters) {
+			if (c.fd >= 0) {
+				close(c.fd);
+			}
+		}
+	}
+	perf_counters(perf_counters const&) = delete;
+	perf_counters& operator=(perf_counters const&) = delete;
+
+	bool available() const {
+		return any_of(m_counters.begin(), m_counters.end(), [](counter const& c) {
+			return c.fd >= 0;
+		});
+	}
+
+	// zeroes the counters, which stay off until resume().
+	void reset() {
+		for (auto& c : m_counters) {
+			if (c.fd >= 0) {
+				ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+				ioctl(c.fd, PERF_EVENT_IOC_RESET, 0);
+			}
+		}
+	}
+
+	void resume() {
+		for (auto& c : m_counters) {
+			if (c.fd >= 0) {
+				ioctl(c.fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+	}
+
+	void pause() {
+		for (auto& c : m_counters) {
+			if (c.fd >= 0) {
+				ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+		}
+	}
+
+	// what was counted between resume() and pause() since the last reset().
+	vector<pair<string, uint64_t>> read_values() {
+		vector<pair<string, uint64_t>> values;
+		for (auto& c : m_counters) {
+			if (c.fd < 0) {
+				continue;
+			}
+			uint64_t value = 0;
+			if (read(c.fd, &value, sizeof(value)) == sizeof(value)) {
+				values.push_back({c.name, value});
+			}
+		}
+		return values;
+	}
+};
+
+struct Config {
+	double min_size = 1e3;
+	double max_size = 1e7;
+	vector<unsigned> threads;
+	vector<string> distributions{"random", "sorted", "reverse", "duplicates"};
+	vector<string> algorithms;
+	unsigned reps = 3;
+	double sort_max = 1e5;
+	double degenerate_max = 1e3;
+	string json;
+	string placement = "none";
+};
+
+struct Result {
+	string algorithm, distribution;
+	size_t size;
+	unsigned threads;
+	bool takes_threads;
+	double sequential, parallel;
+	vector<pair<string, uint64_t>> counters;
+};
+
+vector<value_type> make_input(string const& distribution, size_t size) {
+	vector<value_type> data(size);
+	mt19937 rng(42);
+	if (distribution == "duplicates") {
+		uniform_int_distribution<value_type> few(0, 15);
+		generate(data.begin(), data.end(), [&]() { return few(rng); });
+		return data;
+	}
+	uniform_int_distribution<value_type> any(0, 1000);
+	generate(data.begin(), data.end(), [&]() { return any(rng); });
+	if (distribution == "sorted") {
+		sort(data.begin(), data.end());
+	} else if (distribution == "reverse") {
+		sort(data.begin(), data.end(), greater<value_type>());
+	}
+	return data;
+}
+
+// set while a parallel run is measured; best_time counts its bodies into it.
+perf_counters* measured_counters = nullptr;
+
+/**
+ * prepare() is untimed and rebuilds whatever the timed body consumes.
+ */
+double best_time(unsigned reps, function<void()> const& prepare, function<void()> const& body) {
+	double best = 1e300;
+	for (unsigned i = 0; i < reps; ++i) {
+		prepare();
+		if (measured_counters) {
+			measured_counters->resume();
+		}
+		auto start = chrono::steady_clock::now();
+		body();
+		double const elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if (measured_counters) {
+			measured_counters->pause();
+		}
+		best = min(best, elapsed);
+	}
+	return best;
+}
+
+// keeps results alive so the optimizer cannot drop the work.
+volatile unsigned long long sink;
+
+struct Algorithm {
+	string name;
+	bool is_sort;
+	// false if parallel() ignores its thread count.
+	bool takes_threads;
+	// both return the best wall time over the repetitions.
+	function<double(vector<value_type> const&, unsigned)> sequential;
+	function<double(vector<value_type> const&, unsigned, unsigned)> parallel;
+};
+
+vector<Algorithm> algorithms() {
+	vector<Algorithm> all;
+	all.push_back({"parallelAccumulate", false, true,
+		[](vector<value_type> const& input, unsigned reps) {
+			return best_time(reps, []() {}, [&]() {
+				sink = accumulate(input.begin(), input.end(), 0ull);
+			});
+		},
+		[](vector<value_type> const& input, unsigned reps, unsigned threads) {
+			return best_time(reps, []() {}, [&]() {
+				sink = parallelAccumulate(input.begin(), input.end(), 0ull, threads);
+			});
+		}});
+	all.push_back({"parallel_accumulate", false, true,
+		[](vector<value_type> const& input, unsigned reps) {
+			return best_time(reps, []() {}, [&]() {
+				sink = accumulate(input.begin(), input.end(), 0ull);
+			});
+		},
+		[](vector<value_type> const& input, unsigned reps, unsigned threads) {
+			return best_time(reps, []() {}, [&]() {
+				sink = parallel_accumulate(input.begin(), input.end(), 0ull, threads);
+			});
+		}});
+	// the match is absent, so every element is visited.
+	all.push_back({"parallel_find", false, true,
+		[](vector<value_type> const& input, unsigned reps) {
+			return best_time(reps, []() {}, [&]() {
+				sink = find(input.begin(), input.end(), value_type(~0u)) - input.begin();
+			});
+		},
+		[](vector<value_type> const& input, unsigned reps, unsigned threads) {
+			return best_time(reps, []() {}, [&]() {
+				sink = parallel_find(input.begin(), input.end(), value_type(~0u), threads) - input.begin();
+			});
+		}});
+	all.push_back({"parallel_partial_sum", false, true,
+		[](vector<value_type> const& input, unsigned reps) {
+			vector<value_type> data;
+			return best_time(reps, [&]() { data = input; }, [&]() {
+				partial_sum(data.begin(), data.end(), data.begin());
+				sink = data.back();
+			});
+		},
+		[](vector<value_type> const& input, unsigned reps, unsigned threads) {
+			vector<value_type> data;
+			return best_time(reps, [&]() { data = input; }, [&]() {
+				parallel_partial_sum(data.begin(), data.end(), threads);
+				sink = data.back();
+			});
+		}});
+	// both quicksorts work on lists, so the baseline is list::sort.
+	// std::async decides how many threads it uses.
+	all.push_back({"concurrencyQuickSort", true, false,
+		[](vector<value_type> const& input, unsigned reps) {
+			list<value_type> data;
+			return best_time(reps, [&]() { data.assign(input.begin(), input.end()); }, [&]() {
+				data.sort();
+				sink = data.front();
+			});
+		},
+		[](vector<value_type> const& input, unsigned reps, unsigned) {
+			// ch4 and ch8 both name their sort parallelQuickSort; the signature picks ch4's.
+			list<value_type> (*const async_sort)(list<value_type>) = &parallelQuickSort<value_type>;
+			list<value_type> data;
+			return best_time(reps, [&]() { data.assign(input.begin(), input.end()); }, [&]() {
+				data = async_sort(move(data));
+				sink = data.front();
+			});
+		}});
+	all.push_back({"Sorter", true, true,
+		[](vector<value_type> const& input, unsigned reps) {
+			list<value_type> data;
+			return best_time(reps, [&]() { data.assign(input.begin(), input.end()); }, [&]() {
+				data.sort();
+				sink = data.front();
+			});
+		},
+		[](vector<value_type> const& input, unsigned reps, unsigned threads) {
+			list<value_type> data;
+			return best_time(reps, [&]() { data.assign(input.begin(), input.end()); }, [&]() {
+				data = parallelQuickSort(move(data), threads);
+				sink = data.front();
+			});
+		}});
+	return all;
+}
+
+template <typename T>
+vector<T> parse_list(string const& arg) {
+	vector<T> values;
+	stringstream ss(arg);
+	string item;
+	while (getline(ss, item, ',')) {
+		stringstream conv(item);
+		T value;
+		conv >> value;
+		values.push_back(value);
+	}
+	return values;
+}
+
+Config parse_args(int argc, char** argv) {
+	Config config;
+	for (int i = 1; i < argc; ++i) {
+		string const arg = argv[i];
+		if (i + 1 >= argc) {
+			throw invalid_argument("missing value for " + arg);
+		}
+		string const value = argv[++i];
+		if (arg == "--min-size") {
+			config.min_size = stod(value);
+		} else if (arg == "--max-size") {
+			config.max_size = stod(value);
+		} else if (arg == "--threads") {
+			config.threads = parse_list<unsigned>(value);
+		} else if (arg == "--distributions") {
+			config.distributions = parse_list<string>(value);
+		} else if (arg == "--algorithms") {
+			config.algorithms = parse_list<string>(value);
+		} else if (arg == "--reps") {
+			config.reps = stoul(value);
+		} else if (arg == "--sort-max") {
+			config.sort_max = stod(value);
+		} else if (arg == "--degenerate-max") {
+			config.degenerate_max = stod(value);
+		} else if (arg == "--json") {
+			config.json = value;
+		} else if (arg == "--placement") {
+			config.placement = value;
+		} else {
+			throw invalid_argument("unknown option " + arg);
+		}
+	}
+	if (config.max_size > 1e9) {
+		throw invalid_argument("--max-size is capped at 1e9");
+	}
+	if (config.placement == "compact") {
+		set_thread_placement(placement::compact);
+	} else if (config.placement == "scatter") {
+		set_thread_placement(placement::scatter);
+	} else if (config.placement == "cores") {
+		set_thread_placement(placement::physical_cores);
+	} else if (config.placement != "none") {
+		throw invalid_argument("unknown placement " + config.placement);
+	}
+	if (config.threads.empty()) {
+		unsigned const hardware_threads = thread::hardware_concurrency();
+		for (unsigned t = 1; t <= max(hardware_threads, 1u); t *= 2) {
+			config.threads.push_back(t);
+		}
+	}
+	return config;
+}
+
+void write_json(ostream& out, Config const& config, vector<Result> const& results, bool counters) {
+	out << "{\n  \"benchmark\": \"algorithms\",\n  \"hardware_concurrency\": "
+		<< thread::hardware_concurrency() << ",\n  \"placement\": \"" << config.placement << "\",\n  \"perf_counters\": " << (counters ? "true" : "false")
+		<< ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		Result const& r = results[i];
+		double const speedup = r.sequential / r.parallel;
+		out << "    {\"algorithm\": \"" << r.algorithm << "\", \"distribution\": \"" << r.distribution
+			<< "\", \"size\": " << r.size << ", \"threads\": " << r.threads
+			<< ", \"sequential_s\": " << r.sequential << ", \"parallel_s\": " << r.parallel
+			<< ", \"speedup\": " << speedup << ", \"efficiency\": ";
+		if (r.takes_threads) {
+			out << speedup / r.threads;
+		} else {
+			out << "null";
+		}
+		for (auto const& c : r.counters) {
+			out << ", \"" << c.first << "\": " << c.second;
+		}
+		out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+	Config config;
+	try {
+		config = parse_args(argc, argv);
+	} catch (exception const& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	// with --json - stdout carries only the JSON.
+	ostream& report = config.json == "-" ? cerr : cout;
+	perf_counters counters;
+	if (!counters.available()) {
+		report << "perf_event unavailable, hardware counters disabled" << endl;
+	}
+
+	vector<Result> results;
+	for (string const& distribution : config.distributions) {
+		for (double size = config.min_size; size <= config.max_size * 1.0001; size *= 10) {
+			size_t const n = size_t(llround(size));
+			vector<value_type> const input = make_input(distribution, n);
+			for (Algorithm const& algorithm : algorithms()) {
+				if (!config.algorithms.empty() &&
+					find(config.algorithms.begin(), config.algorithms.end(), algorithm.name) == config.algorithms.end()) {
+					continue;
+				}
+				bool const degenerate = distribution == "sorted" || distribution == "reverse" || distribution == "duplicates";
+				if (algorithm.is_sort && n > (degenerate ? config.degenerate_max : config.sort_max)) {
+					continue;
+				}
+				double const sequential = algorithm.sequential(input, config.reps);
+				for (unsigned threads : config.threads) {
+					Result res;
+					res.algorithm = algorithm.name;
+					res.distribution = distribution;
+					res.size = n;
+					res.threads = threads;
+					res.takes_threads = algorithm.takes_threads;
+					res.sequential = sequential;
+					counters.reset();
+					measured_counters = &counters;
+					res.parallel = algorithm.parallel(input, config.reps, threads);
+					measured_counters = nullptr;
+					res.counters = counters.read_values();
+					double const speedup = sequential / res.parallel;
+					report << algorithm.name << " " << distribution << " n=" << n << " threads=" << threads
+						<< " : seq " << sequential * 1e3 << " ms, par " << res.parallel * 1e3 << " ms"
+						<< ", speedup " << speedup << ", efficiency ";
+					if (algorithm.takes_threads) {
+						report << speedup / threads;
+					} else {
+						report << "n/a";
+					}
+					for (auto const& c : res.counters) {
+						report << ", " << c.first << " " << c.second;
+					}
+					report << endl;
+					results.push_back(res);
+				}
+			}
+		}
+	}
+
+	if (config.json == "-") {
+		write_json(cout, config, results, counters.available());
+	} else if (!config.json.empty()) {
+		ofstream out(config.json);
+		write_json(out, config, results, counters.available());
+	}
+	return 0;
+}
@@ -0,0 +1,407 @@
+/**
+ * Throughput and latency of the concurrent containers.
+ *
+ * g++ -std=c++17 -O2 -pthread bench/containers_bench.cpp -o containers_bench
+ * ./containers_bench --producers 1,2,4 --consumers 1,2,4 --payload 8,256 --ops 200000 --json result.json
+ *
+ * Without --mix, producers push --ops items each and consumers pop until all
+ * of them are drained. With --mix R every thread does --ops operations, a
+ * push with probability R and a try-pop otherwise.
+ * --json - writes the JSON to stdout and the text report to stderr.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "../ch4/threadSafeQueue.h"
+#include "../ch6/ThreadSafe_queue.h"
+#include "../ch6/ThreadSafe_queue_better.h"
+#include "../ch6/threadSafe_stack.h"
+#include "../ch6/flat_combining.h"
+#include "../ch7/free_lock_stack.h"
+#include "../ch7/node_pool.h"
+#include "../ch8/sharded_queue.h"
+
+using namespace std;
+
+template <size_t size>
+struct Payload {
+	array<char, size> bytes;
+	Payload(unsigned long seed = 0) {
+		bytes.fill(char(seed));
+	}
+};
+
+/**
+ * Every container behind the same push / try_pop pair.
+ */
+template <typename value_type>
+struct ThreadSafeQueue_adapter {
+	ThreadSafeQueue<value_type> c;
+	void push(value_type value) { c.push(move(value)); }
+	bool try_pop(value_type& out) { return c.try_pop(out); }
+};
+
+template <typename value_type>
+struct ThreadSafe_queue_adapter {
+	ThreadSafe_queue<value_type> c;
+	void push(value_type value) { c.push(move(value)); }
+	bool try_pop(value_type& out) { return c.tryPop(out); }
+};
+
+template <typename value_type, typename Alloc>
+struct ThreadSafe_queue_better_adapter {
+	ThreadSafe_queue_better<value_type, Alloc> c;
+	void push(value_type value) { c.push(move(value)); }
+	bool try_pop(value_type& out) {
+		optional<value_type> res = c.try_pop();
+		if (!res) {
+			return false;
+		}
+		out = move(*res);
+		return true;
+	}
+};
+
+template <typename value_type>
+struct ThreadSafe_stack_adapter {
+	ThreadSafe_stack<value_type> c;
+	void push(value_type value) { c.push(move(value)); }
+	bool try_pop(value_type& out) {
+		optional<value_type> res = c.try_pop();
+		if (!res) {
+			return false;
+		}
+		out = move(*res);
+		return true;
+	}
+};
+
+template <typename Container>
+struct flat_combining_adapter {
+	flat_combining<Container> c;
+	void push(typename Container::value_type value) { c.push(move(value)); }
+	bool try_pop(typename Container::value_type& out) { return c.try_pop(out); }
+};
+
+template <typename value_type>
+struct ShardedQueue_adapter {
+	ShardedQueue<value_type> c;
+	void push(value_type value) { c.push(move(value)); }
+	bool try_pop(value_type& out) {
+		optional<value_type> res = c.try_pop();
+		if (!res) {
+			return false;
+		}
+		out = move(*res);
+		return true;
+	}
+};
+
+template <typename value_type, typename Alloc>
+struct free_lock_stack_adapter {
+	free_lock_stack<value_type, Alloc> c;
+	void push(value_type value) { c.push(value); }
+	bool try_pop(value_type& out) {
+		shared_ptr<value_type> res = c.pop();
+		if (!res) {
+			return false;
+		}
+		out = move(*res);
+		return true;
+	}
+};
+
+struct Config {
+	vector<string> containers;
+	vector<unsigned> producers{1};
+	vector<unsigned> consumers{1};
+	vector<size_t> payloads{8};
+	vector<double> mixes;
+	unsigned long ops = 100000;
+	string json;
+};
+
+struct Percentiles {
+	double p50 = 0, p99 = 0, p999 = 0;
+	unsigned long count = 0;
+};
+
+struct Result {
+	string container;
+	unsigned producers, consumers;
+	size_t payload;
+	double mix;
+	unsigned long ops;
+	double seconds;
+	Percentiles push_ns, pop_ns;
+};
+
+Percentiles percentiles(vector<vector<uint32_t>>& per_thread) {
+	vector<uint32_t> all;
+	for (auto& samples : per_thread) {
+		all.insert(all.end(), samples.begin(), samples.end());
+	}
+	Percentiles res;
+	res.count = all.size();
+	if (all.empty()) {
+		return res;
+	}
+	auto at = [&](double q) {
+		auto nth = all.begin() + min<size_t>(all.size() - 1, size_t(q * all.size()));
+		nth_element(all.begin(), nth, all.end());
+		return double(*nth);
+	};
+	res.p50 = at(0.5);
+	res.p99 = at(0.99);
+	res.p999 = at(0.999);
+	return res;
+}
+
+inline uint32_t elapsed_ns(chrono::steady_clock::time_point start) {
+	return uint32_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+}
+
+template <typename Container, typename value_type>
+Result run(Config const& config, unsigned producers, unsigned consumers, double mix) {
+	Container container;
+	unsigned const thread_count = producers + consumers;
+	vector<vector<uint32_t>> push_lat(thread_count), pop_lat(thread_count);
+	atomic<unsigned> ready{0};
+	atomic<bool> go{false};
+	atomic<unsigned long> remaining(producers * config.ops);
+	// without consumers nothing is popped, only the pushes count.
+	unsigned long total_ops = mix >= 0 ? thread_count * config.ops : (consumers ? 2 : 1) * producers * config.ops;
+
+	auto wait_for_start = [&]() {
+		++ready;
+		while (!go.load()) {
+			this_thread::yield();
+		}
+	};
+
+	vector<thread> threads;
+	for (unsigned t = 0; t < thread_count; ++t) {
+		push_lat[t].reserve(config.ops);
+		pop_lat[t].reserve(config.ops);
+		threads.push_back(thread([&, t]() {
+			value_type item(t);
+			wait_for_start();
+			if (mix >= 0) {
+				mt19937 rng(t);
+				bernoulli_distribution is_push(mix);
+				for (unsigned long i = 0; i < config.ops; ++i) {
+					auto start = chrono::steady_clock::now();
+					if (is_push(rng)) {
+						container.push(item);
+						push_lat[t].push_back(elapsed_ns(start));
+					} else {
+						container.try_pop(item);
+						pop_lat[t].push_back(elapsed_ns(start));
+					}
+				}
+			} else if (t < producers) {
+				for (unsigned long i = 0; i < config.ops; ++i) {
+					auto start = chrono::steady_clock::now();
+					container.push(item);
+					push_lat[t].push_back(elapsed_ns(start));
+				}
+			} else {
+				while (remaining.load(memory_order_relaxed) > 0) {
+					auto start = chrono::steady_clock::now();
+					if (container.try_pop(item)) {
+						pop_lat[t].push_back(elapsed_ns(start));
+						remaining.fetch_sub(1, memory_order_relaxed);
+					}
+				}
+			}
+		}));
+	}
+	while (ready.load() != thread_count) {
+		this_thread::yield();
+	}
+	auto start = chrono::steady_clock::now();
+	go = true;
+	for (auto& thd : threads) {
+		thd.join();
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	Result res;
+	res.producers = producers;
+	res.consumers = consumers;
+	res.payload = sizeof(value_type);
+	res.mix = mix;
+	res.ops = total_ops;
+	res.seconds = seconds;
+	res.push_ns = percentiles(push_lat);
+	res.pop_ns = percentiles(pop_lat);
+	return res;
+}
+
+typedef function<Result(Config const&, unsigned, unsigned, double)> Runner;
+
+template <typename value_type>
+vector<pair<string, Runner>> runners() {
+	return {
+		{"ThreadSafeQueue", run<ThreadSafeQueue_adapter<value_type>, value_type>},
+		{"ThreadSafe_queue", run<ThreadSafe_queue_adapter<value_type>, value_type>},
+		{"ThreadSafe_queue_better", run<ThreadSafe_queue_better_adapter<value_type, allocator<value_type>>, value_type>},
+		{"ThreadSafe_queue_better_pool", run<ThreadSafe_queue_better_adapter<value_type, pool_allocator<value_type>>, value_type>},
+		{"ShardedQueue", run<ShardedQueue_adapter<value_type>, value_type>},
+		{"ThreadSafe_stack", run<ThreadSafe_stack_adapter<value_type>, value_type>},
+		{"flat_combining_queue", run<flat_combining_adapter<queue<value_type>>, value_type>},
+		{"flat_combining_stack", run<flat_combining_adapter<stack<value_type>>, value_type>},
+		{"free_lock_stack", run<free_lock_stack_adapter<value_type, allocator<value_type>>, value_type>},
+		{"free_lock_stack_pool", run<free_lock_stack_adapter<value_type, pool_allocator<value_type>>, value_type>},
+	};
+}
+
+vector<pair<string, Runner>> runners_for(size_t payload) {
+	switch (payload) {
+	case 8: return runners<Payload<8>>();
+	case 64: return runners<Payload<64>>();
+	case 256: return runners<Payload<256>>();
+	case 1024: return runners<Payload<1024>>();
+	case 4096: return runners<Payload<4096>>();
+	}
+	throw invalid_argument("payload must be one of 8, 64, 256, 1024, 4096");
+}
+
+template <typename T>
+vector<T> parse_list(string const& arg) {
+	vector<T> values;
+	stringstream ss(arg);
+	string item;
+	while (getline(ss, item, ',')) {
+		stringstream conv(item);
+		T value;
+		conv >> value;
+		values.push_back(value);
+	}
+	return values;
+}
+
+Config parse_args(int argc, char** argv) {
+	Config config;
+	for (int i = 1; i < argc; ++i) {
+		string const arg = argv[i];
+		if (i + 1 >= argc) {
+			throw invalid_argument("missing value for " + arg);
+		}
+		string const value = argv[++i];
+		if (arg == "--containers") {
+			config.containers = parse_list<string>(value);
+		} else if (arg == "--producers") {
+			config.producers = parse_list<unsigned>(value);
+		} else if (arg == "--consumers") {
+			config.consumers = parse_list<unsigned>(value);
+		} else if (arg == "--payload") {
+			config.payloads = parse_list<size_t>(value);
+		} else if (arg == "--mix") {
+			config.mixes = parse_list<double>(value);
+		} else if (arg == "--ops") {
+			config.ops = stoul(value);
+		} else if (arg == "--json") {
+			config.json = value;
+		} else {
+			throw invalid_argument("unknown option " + arg);
+		}
+	}
+	return config;
+}
+
+void write_percentiles(ostream& out, Percentiles const& p) {
+	out << "{\"count\": " << p.count << ", \"p50\": " << p.p50
+		<< ", \"p99\": " << p.p99 << ", \"p999\": " << p.p999 << "}";
+}
+
+void write_json(ostream& out, vector<Result> const& results) {
+	out << "{\n  \"benchmark\": \"containers\",\n  \"hardware_concurrency\": "
+		<< thread::hardware_concurrency() << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		Result const& r = results[i];
+		out << "    {\"container\": \"" << r.container << "\", \"producers\": " << r.producers
+			<< ", \"consumers\": " << r.consumers << ", \"payload\": " << r.payload
+			<< ", \"mix\": " << r.mix << ", \"ops\": " << r.ops
+			<< ", \"seconds\": " << r.seconds << ", \"ops_per_second\": " << r.ops / r.seconds
+			<< ", \"push_ns\": ";
+		write_percentiles(out, r.push_ns);
+		out << ", \"pop_ns\": ";
+		write_percentiles(out, r.pop_ns);
+		out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+	Config config;
+	try {
+		config = parse_args(argc, argv);
+	} catch (exception const& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	for (string const& name : config.containers) {
+		vector<pair<string, Runner>> const known = runners<Payload<8>>();
+		if (none_of(known.begin(), known.end(), [&name](pair<string, Runner> const& runner) {
+				return runner.first == name;
+			})) {
+			cerr << "unknown container " << name << endl;
+			return 1;
+		}
+	}
+
+	// with --json - stdout carries only the JSON.
+	ostream& report = config.json == "-" ? cerr : cout;
+	// a negative mix selects the producer/consumer workload.
+	vector<double> mixes = config.mixes.empty() ? vector<double>{-1} : config.mixes;
+	vector<Result> results;
+	for (size_t payload : config.payloads) {
+		vector<pair<string, Runner>> all;
+		try {
+			all = runners_for(payload);
+		} catch (exception const& e) {
+			cerr << e.what() << endl;
+			return 1;
+		}
+		for (auto const& runner : all) {
+			if (!config.containers.empty() &&
+				find(config.containers.begin(), config.containers.end(), runner.first) == config.containers.end()) {
+				continue;
+			}
+			for (double mix : mixes) {
+				for (unsigned producers : config.producers) {
+					for (unsigned consumers : config.consumers) {
+						Result res = runner.second(config, producers, consumers, mix);
+						res.container = runner.first;
+						report << res.container << " P=" << producers << " C=" << consumers
+							<< " payload=" << payload << (mix >= 0 ? " mix=" + to_string(mix) : "")
+							<< " : " << res.ops / res.seconds / 1e6 << " Mops/s"
+							<< ", push p50/p99/p999 " << res.push_ns.p50 << "/" << res.push_ns.p99 << "/" << res.push_ns.p999 << " ns"
+							<< ", pop p50/p99/p999 " << res.pop_ns.p50 << "/" << res.pop_ns.p99 << "/" << res.pop_ns.p999 << " ns"
+							<< endl;
+						results.push_back(res);
+					}
+				}
+			}
+		}
+	}
+
+	if (config.json == "-") {
+		write_json(cout, results);
+	} else if (!config.json.empty()) {
+		ofstream out(config.json);
+		write_json(out, results);
+	}
+	return 0;
+}
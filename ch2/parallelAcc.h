@@ -0,0 +1,18 @@
+#ifndef PARALLEL_ACC
+#define PARALLEL_ACC
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include "../ch8/parallel_engine.h"
+using namespace std;
+
+template <typename Iterator, typename value>
+value parallelAccumulate(Iterator first, Iterator last, value init,
+		unsigned long const hardwareThreads = thread::hardware_concurrency()) {
+	return parallel_reduce(first, last, init, plus<value>(), hardwareThreads);
+}
+
+#endif
@@ -1,21 +1,24 @@
+#include "../ch5/seqlock.h"
+
 class Y {
 private:
-	int m_value;
-	mutable mutex m_mutex;
+	seqlock<int> m_value;
 
 	int getValue() const {
-		lock_guard<mutex> lock(m_mutex);
-		return m_value;
+		return m_value.read();
 	}
 
 public:
 	Y(int org) : m_value(org) {}
+
+	void setValue(int value) {
+		m_value.write(value);
+	}
+
 	friend bool operator==(Y& lhs, Y& rhs) {
 		if (&lhs == &rhs) {
 			return true;
 		}
-		const int lvalue = lhs.getValue();
-		const int rvalue = rhs.getValue();
-		return lvalue == rvalue;
+		return rhs.m_value.compare(lhs.getValue());
 	}
 };
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <functional>
+#include "../ch5/seqlock.h"
 using namespace std;
 
 class Data {
@@ -14,12 +16,10 @@ public:
 
 class DataWrapper {
 private:
-	Data data;
-	mutex m;
+	seqlock<Data> data;
 public:
 	void processData(function<void (Data)> func) {
-		lock_guard<mutex> guard(m);
-		func(data);
+		func(data.read());
 	}
 };
 
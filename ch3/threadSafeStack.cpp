@@ -1,8 +1,11 @@
 #include <exception>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <stack>
 
+using namespace std;
+
 struct emptyStack : exception {
 	const char* what() const throw();
 };
@@ -15,18 +18,24 @@ private:
 public:
 	threadSafeStack(){}
 	threadSafeStack(const threadSafeStack& other) {
-		lock_gurad<mutex> lock(m_mutex);
-		m_stack = other.data;
+		lock_guard<mutex> lock(other.m_mutex);
+		m_stack = other.m_stack;
 	}
 	threadSafeStack& operator=(const threadSafeStack&) = delete;
 
 	void push(valueType value) {
-		lock_gurad<mutex> lock(m_mutex);
-		m_stack.push(value);
+		lock_guard<mutex> lock(m_mutex);
+		m_stack.push(move(value));
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		lock_guard<mutex> lock(m_mutex);
+		m_stack.emplace(forward<Args>(args)...);
 	}
 
 	shared_ptr<valueType> pop() {
-		lock_gurad<mutex> lock(m_mutex);
+		lock_guard<mutex> lock(m_mutex);
 		if (m_stack.empty()) {
 			throw emptyStack();
 		}
@@ -36,7 +45,7 @@ public:
 	}
 
 	void pop(valueType& value) {
-		lock_gurad<mutex> lock(m_mutex);
+		lock_guard<mutex> lock(m_mutex);
 		if (m_stack.empty()) {
 			throw emptyStack();
 		}
@@ -44,8 +53,22 @@ public:
 		m_stack.pop();
 	}
 
+	/**
+	 * The element is only popped once the result holds it,
+	 * so a throwing copy leaves the stack untouched.
+	 */
+	optional<valueType> try_pop() {
+		lock_guard<mutex> lock(m_mutex);
+		if (m_stack.empty()) {
+			return nullopt;
+		}
+		optional<valueType> res(move_if_noexcept(m_stack.top()));
+		m_stack.pop();
+		return res;
+	}
+
 	bool empty() const {
-		lock_gurad<mutex> lock(m_mutex);
+		lock_guard<mutex> lock(m_mutex);
 		return m_stack.empty();
 	}
 };
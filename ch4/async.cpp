@@ -1,22 +1,29 @@
 #include <iostream>
 #include <future>
-#include <mutex>
+#include <functional>
+#include <vector>
+#include "../ch8/combinable.h"
 
 using namespace std;
 
-int total{0};
-mutex m_mutex;
+// every thread adds into its own slot, no lock and no shared cache line.
+combinable<long> total;
 
-int addUp() {
-	lock_guard<mutex> lock(m_mutex);
+void addUp() {
+	long& local = total.local();
 	for (int i = 0; i < 10000; ++i) {
-		total += i;
+		local += i;
 	}
-	return total;
 }
 
 int main() {
-	auto thd1 = async(addUp);
-	cout << thd1.get() << endl;
+	vector<future<void>> futures;
+	for (int i = 0; i < 4; ++i) {
+		futures.push_back(async(launch::async, addUp));
+	}
+	for (auto& f : futures) {
+		f.get();
+	}
+	cout << total.combine(plus<long>()) << endl;
 	return 0;
 }
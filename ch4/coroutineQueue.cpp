@@ -0,0 +1,97 @@
+// g++ -std=c++20 -pthread coroutineQueue.cpp
+#include "threadSafeQueue.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A few threads running whatever is posted to them.
+ * An empty function tells a worker to stop.
+ */
+class loop_executor {
+private:
+	ThreadSafeQueue<function<void()>> m_work;
+	vector<thread> m_threads;
+
+public:
+	explicit loop_executor(unsigned threadCount) {
+		for (unsigned i = 0; i < threadCount; ++i) {
+			m_threads.push_back(thread([this]() {
+				while (function<void()> func = m_work.wait_pop()) {
+					func();
+				}
+			}));
+		}
+	}
+
+	~loop_executor() {
+		for (size_t i = 0; i < m_threads.size(); ++i) {
+			m_work.push(function<void()>());
+		}
+		for (auto& thd : m_threads) {
+			thd.join();
+		}
+	}
+
+	template <typename Function>
+	void post(Function func) {
+		m_work.push(function<void()>(move(func)));
+	}
+};
+
+// fire-and-forget coroutine, runs until its first suspension when called.
+struct detached_task {
+	struct promise_type {
+		detached_task get_return_object() { return {}; }
+		suspend_never initial_suspend() noexcept { return {}; }
+		suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { terminate(); }
+	};
+};
+
+detached_task consumer(ThreadSafeQueue<int>& queue, loop_executor& executor,
+		atomic<long long>& total, atomic<int>& remaining) {
+	int value = co_await queue.async_pop(executor);
+	total += value;
+	--remaining;
+}
+
+int main() {
+	ThreadSafeQueue<int> queue;
+	int const consumers = 20000;
+	atomic<long long> total{0};
+	atomic<int> remaining{consumers};
+	{
+		loop_executor executor(2);
+		for (int i = 0; i < consumers; ++i) {
+			consumer(queue, executor, total, remaining);
+		}
+		thread producer([&]() {
+			for (int value = 1; value <= consumers; ++value) {
+				queue.push(value);
+			}
+		});
+		producer.join();
+		while (remaining.load()) {
+			this_thread::yield();
+		}
+	}
+	cout << consumers << " consumers on 2 threads, total " << total
+		<< " == " << (long long)consumers * (consumers + 1) / 2 << endl;
+
+	// without an executor the consumer resumes on the pushing thread.
+	[](ThreadSafeQueue<int>& queue) -> detached_task {
+		int value = co_await queue.async_pop();
+		cout << "Resumed inline with " << value << endl;
+	}(queue);
+	queue.push(42);
+	return 0;
+}
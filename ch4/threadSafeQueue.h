@@ -0,0 +1,237 @@
+#ifndef THREADSAFEQUEUE
+#define THREADSAFEQUEUE
+
+#include <memory> // for shared_ptr
+#include <mutex> // for mutex
+#include <condition_variable>
+#include <optional>
+#include <queue>
+#include "../ch8/trace.h" // for TRACE_LOCK and TRACE_LOCK_WAIT, compiled out by default
+#if defined(__cpp_impl_coroutine)
+#include <coroutine> // for async_pop
+#endif
+
+using namespace std;
+
+#if defined(__cpp_impl_coroutine)
+/**
+ * Resumes a woken consumer right on the pushing thread.
+ * Any type with post(callable) can be used instead.
+ */
+struct inline_executor {
+	template <typename Function>
+	void post(Function&& func) {
+		func();
+	}
+};
+#endif
+
+template <typename value_type>
+class ThreadSafeQueue {
+private:
+	mutable mutex m_mutex;
+	queue<value_type> m_data;
+	condition_variable m_conditionVar;
+
+#if defined(__cpp_impl_coroutine)
+	/**
+	 * A suspended async_pop(). It lives in the coroutine frame,
+	 * push() fills its slot and hands the coroutine to its executor.
+	 */
+	struct coroutine_waiter {
+		coroutine_handle<> handle;
+		optional<value_type> slot;
+		void* executor;
+		void (*schedule)(void* executor, coroutine_handle<> handle);
+		coroutine_waiter* next;
+	};
+	coroutine_waiter* m_waitersHead = nullptr;
+	coroutine_waiter* m_waitersTail = nullptr;
+
+	// called with m_mutex held.
+	coroutine_waiter* takeWaiter() {
+		coroutine_waiter* waiter = m_waitersHead;
+		if (waiter) {
+			m_waitersHead = waiter->next;
+			if (!m_waitersHead) {
+				m_waitersTail = nullptr;
+			}
+		}
+		return waiter;
+	}
+
+	template <typename... Args>
+	bool handToWaiter(unique_lock<mutex>& lock, Args&&... args) {
+		coroutine_waiter* waiter = takeWaiter();
+		if (!waiter) {
+			return false;
+		}
+		waiter->slot.emplace(forward<Args>(args)...);
+		lock.unlock();
+		waiter->schedule(waiter->executor, waiter->handle);
+		return true;
+	}
+#endif
+
+public:
+	ThreadSafeQueue() {}
+	
+	ThreadSafeQueue(const ThreadSafeQueue& other) {
+		lock_guard<mutex> lock(other.m_mutex);
+		m_data = other.m_data;
+	}
+
+	ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
+
+	void push(value_type value) {
+		TRACE_LOCK_WAIT(unique_lock<mutex> lock(m_mutex));
+		TRACE_INSTANT("queue push");
+#if defined(__cpp_impl_coroutine)
+		if (handToWaiter(lock, move(value))) {
+			return;
+		}
+#endif
+		m_data.push(move(value));
+		m_conditionVar.notify_one();
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		TRACE_LOCK_WAIT(unique_lock<mutex> lock(m_mutex));
+		TRACE_INSTANT("queue push");
+#if defined(__cpp_impl_coroutine)
+		if (handToWaiter(lock, forward<Args>(args)...)) {
+			return;
+		}
+#endif
+		m_data.emplace(forward<Args>(args)...);
+		m_conditionVar.notify_one();
+	}
+
+	bool try_pop(value_type& result) {
+		lock_guard<mutex> lock(m_mutex);
+		if (m_data.empty()) {
+			return false;
+		}
+		result = move(m_data.front());
+		m_data.pop();
+		return true;
+	}
+
+	/**
+	 * The front is only popped once the result holds it,
+	 * so a throwing copy leaves the queue untouched.
+	 */
+	optional<value_type> try_pop() {
+		TRACE_LOCK(lock_guard<mutex> lock(m_mutex));
+		if (m_data.empty()) {
+			return nullopt;
+		}
+		TRACE_INSTANT("queue pop");
+		optional<value_type> result(move_if_noexcept(m_data.front()));
+		m_data.pop();
+		return result;
+	}
+
+	void wait_and_pop(value_type& result) {
+		unique_lock<mutex> uniqueLock(m_mutex);
+		m_conditionVar.wait(uniqueLock, [this]() {
+			return !this->m_data.empty();
+		});
+		result = move(m_data.front());
+		m_data.pop();
+		uniqueLock.unlock();
+	}
+
+	shared_ptr<value_type> wait_and_pop() {
+		unique_lock<mutex> uniqueLock(m_mutex);
+		m_conditionVar.wait(uniqueLock, [this]() {
+			return !this->m_data.empty();
+		});
+		shared_ptr<value_type> result(make_shared<value_type>(move(m_data.front())));
+		m_data.pop();
+		uniqueLock.unlock();
+		return result;
+	}
+
+	value_type wait_pop() {
+		TRACE_LOCK_WAIT(unique_lock<mutex> uniqueLock(m_mutex));
+		m_conditionVar.wait(uniqueLock, [this]() {
+			return !this->m_data.empty();
+		});
+		TRACE_INSTANT("queue pop");
+		value_type result(move_if_noexcept(m_data.front()));
+		m_data.pop();
+		return result;
+	}
+
+#if defined(__cpp_impl_coroutine)
+	template <typename Executor>
+	class pop_awaiter {
+	private:
+		ThreadSafeQueue& m_queue;
+		Executor& m_executor;
+		coroutine_waiter m_waiter;
+
+	public:
+		pop_awaiter(ThreadSafeQueue& queue, Executor& executor) :
+			m_queue(queue), m_executor(executor) {}
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		// returning false resumes at once, the queue already had a value.
+		bool await_suspend(coroutine_handle<> handle) {
+			lock_guard<mutex> lock(m_queue.m_mutex);
+			if (!m_queue.m_data.empty()) {
+				m_waiter.slot.emplace(move(m_queue.m_data.front()));
+				m_queue.m_data.pop();
+				return false;
+			}
+			m_waiter.handle = handle;
+			m_waiter.executor = &m_executor;
+			m_waiter.schedule = [](void* executor, coroutine_handle<> handle) {
+				static_cast<Executor*>(executor)->post([handle]() {
+					handle.resume();
+				});
+			};
+			m_waiter.next = nullptr;
+			if (m_queue.m_waitersTail) {
+				m_queue.m_waitersTail->next = &m_waiter;
+			} else {
+				m_queue.m_waitersHead = &m_waiter;
+			}
+			m_queue.m_waitersTail = &m_waiter;
+			return true;
+		}
+
+		value_type await_resume() {
+			return move(*m_waiter.slot);
+		}
+	};
+
+	/**
+	 * co_await queue.async_pop(executor) suspends the coroutine instead of a thread.
+	 * The next push() resumes it through executor.post() after releasing the lock.
+	 * Waiting coroutines are served first-come first-served, before blocked threads.
+	 * A suspended consumer must not be destroyed before it is resumed.
+	 */
+	template <typename Executor>
+	pop_awaiter<Executor> async_pop(Executor& executor) {
+		return pop_awaiter<Executor>(*this, executor);
+	}
+
+	pop_awaiter<inline_executor> async_pop() {
+		static inline_executor executor;
+		return pop_awaiter<inline_executor>(*this, executor);
+	}
+#endif
+
+	bool empty() const {
+		lock_guard<mutex> lock(m_mutex);
+		return m_data.empty();
+	}
+};
+
+#endif
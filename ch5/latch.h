@@ -0,0 +1,108 @@
+#ifndef LATCH
+#define LATCH
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+using namespace std;
+
+inline void spin_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+/**
+ * One-shot event: wait() returns once set() was called, and everything
+ * written before set() is visible after wait().
+ * Waiters spin for a short while, since the handoff is usually imminent,
+ * then sleep in atomic::wait. set() only notifies if somebody went to sleep.
+ */
+class event {
+private:
+	enum : unsigned { unset, set_, sleeping };
+	atomic<unsigned> m_state{unset};
+
+public:
+	event() = default;
+	event(event const&) = delete;
+	event& operator=(event const&) = delete;
+
+	void set() {
+		if (m_state.exchange(set_, memory_order_release) == sleeping) {
+#if defined(__cpp_lib_atomic_wait)
+			m_state.notify_all();
+#endif
+		}
+	}
+
+	bool is_set() const {
+		return m_state.load(memory_order_acquire) == set_;
+	}
+
+	void wait() {
+		for (int spin = 0; spin < 128; ++spin) {
+			if (is_set()) {
+				return;
+			}
+			spin_pause();
+		}
+		unsigned current = m_state.load(memory_order_acquire);
+		while (current != set_) {
+			if (current == unset && !m_state.compare_exchange_weak(current, sleeping, memory_order_acquire)) {
+				continue;
+			}
+#if defined(__cpp_lib_atomic_wait)
+			m_state.wait(sleeping, memory_order_acquire);
+#else
+			this_thread::yield();
+#endif
+			current = m_state.load(memory_order_acquire);
+		}
+	}
+};
+
+/**
+ * Opens once count_down() was called count times in total; what every
+ * arriving thread wrote before its count_down() is visible after wait().
+ * The standard library has this as std::latch from C++20 on.
+ */
+class countdown {
+private:
+	atomic<ptrdiff_t> m_count;
+	event m_done;
+
+public:
+	explicit countdown(ptrdiff_t count) : m_count(count) {
+		if (count <= 0) {
+			m_done.set();
+		}
+	}
+	countdown(countdown const&) = delete;
+	countdown& operator=(countdown const&) = delete;
+
+	void count_down(ptrdiff_t n = 1) {
+		// acq_rel chains every arrival's writes into the final set().
+		if (m_count.fetch_sub(n, memory_order_acq_rel) == n) {
+			m_done.set();
+		}
+	}
+
+	bool try_wait() const {
+		return m_done.is_set();
+	}
+
+	void wait() {
+		m_done.wait();
+	}
+
+	void arrive_and_wait(ptrdiff_t n = 1) {
+		count_down(n);
+		wait();
+	}
+};
+
+#endif
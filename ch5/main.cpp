@@ -2,27 +2,26 @@
 #include <atomic>
 #include <thread>
 #include <vector>
+#include "latch.h"
 
 using namespace std;
 
-vector<int> data;
-atomic<bool> dataReady(false);
+vector<int> sharedData;
+event dataReady;
 
-void read() {
-	while (!dataReady.load()) {
-		this_thread::sleep_for(chrono::milliseconds(1));
-	}
-	cout << data[0] << endl;
+void reader() {
+	dataReady.wait();
+	cout << sharedData[0] << endl;
 }
 
-void write() {
-	data.push_back(1);
-	dataReady = true;
+void writer() {
+	sharedData.push_back(1);
+	dataReady.set();
 }
 
 int main() {
-	thread readThread(read);
-	thread writeThread(write);
+	thread readThread(reader);
+	thread writeThread(writer);
 	readThread.join();
 	writeThread.join();
 	return 0;
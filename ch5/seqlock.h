@@ -0,0 +1,111 @@
+#ifndef SEQLOCK
+#define SEQLOCK
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "latch.h"
+
+using namespace std;
+
+/**
+ * A small value that many threads read and few write.
+ * The sequence number is odd while a write is in progress. A reader copies
+ * the value between two loads of the sequence and retries if it changed,
+ * so reads never write shared memory and never block a writer.
+ * Writers exclude each other by moving the sequence from even to odd.
+ *
+ * The value is kept in atomic words so that the optimistic copy
+ * racing with a writer is not a data race.
+ */
+template <typename T>
+class seqlock {
+private:
+	static_assert(is_trivially_copyable<T>::value, "seqlock copies the value bytewise");
+	static constexpr size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	atomic<unsigned long> m_sequence{0};
+	atomic<uint64_t> m_words[word_count];
+
+	void storeWords(T const& value) {
+		uint64_t words[word_count] = {};
+		memcpy(words, &value, sizeof(T));
+		for (size_t i = 0; i < word_count; ++i) {
+			m_words[i].store(words[i], memory_order_relaxed);
+		}
+	}
+
+	unsigned long lockWriter() {
+		unsigned long sequence = m_sequence.load(memory_order_relaxed);
+		while (true) {
+			if (!(sequence & 1) && m_sequence.compare_exchange_weak(sequence, sequence + 1, memory_order_acquire)) {
+				// the odd sequence has to be visible before any of the new words.
+				atomic_thread_fence(memory_order_release);
+				return sequence + 1;
+			}
+			spin_pause();
+			sequence = m_sequence.load(memory_order_relaxed);
+		}
+	}
+
+public:
+	explicit seqlock(T const& value = T()) {
+		storeWords(value);
+	}
+	seqlock(seqlock const&) = delete;
+	seqlock& operator=(seqlock const&) = delete;
+
+	T read() const {
+		uint64_t words[word_count];
+		while (true) {
+			unsigned long const before = m_sequence.load(memory_order_acquire);
+			if (before & 1) {
+				spin_pause();
+				continue;
+			}
+			for (size_t i = 0; i < word_count; ++i) {
+				words[i] = m_words[i].load(memory_order_relaxed);
+			}
+			atomic_thread_fence(memory_order_acquire);
+			if (m_sequence.load(memory_order_relaxed) == before) {
+				break;
+			}
+		}
+		T value;
+		memcpy(&value, words, sizeof(T));
+		return value;
+	}
+
+	bool compare(T const& expected) const {
+		return read() == expected;
+	}
+
+	void write(T const& value) {
+		unsigned long const sequence = lockWriter();
+		storeWords(value);
+		m_sequence.store(sequence + 1, memory_order_release);
+	}
+
+	// read-modify-write with other writers held off.
+	template <typename Function>
+	void update(Function func) {
+		unsigned long const sequence = lockWriter();
+		uint64_t words[word_count];
+		for (size_t i = 0; i < word_count; ++i) {
+			words[i] = m_words[i].load(memory_order_relaxed);
+		}
+		T value;
+		memcpy(&value, words, sizeof(T));
+		try {
+			func(value);
+		} catch (...) {
+			m_sequence.store(sequence + 1, memory_order_release);
+			throw;
+		}
+		storeWords(value);
+		m_sequence.store(sequence + 1, memory_order_release);
+	}
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef THREADSAFE_QUEUE
+#define THREADSAFE_QUEUE
+
+#include <iostream>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <optional>
+
+using namespace std;
+
+template <typename value_type>
+class ThreadSafe_queue {
+private:
+	queue<value_type> data;
+	condition_variable m_cv;
+	mutable mutex m_mutex;
+
+public:
+	ThreadSafe_queue() {}
+	ThreadSafe_queue(const ThreadSafe_queue& other) {
+		lock_guard<mutex> lock(other.m_mutex);
+		data = other.data;
+	}
+	ThreadSafe_queue& operator=(const ThreadSafe_queue&) = delete;
+
+	void push(value_type value) {
+		lock_guard<mutex> lock(m_mutex);
+		data.push(move(value));
+		m_cv.notify_one();
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		lock_guard<mutex> lock(m_mutex);
+		data.emplace(forward<Args>(args)...);
+		m_cv.notify_one();
+	}
+
+	void waitPop(value_type& result) {
+		unique_lock<mutex> lock(m_mutex);
+		m_cv.wait(lock, [this]() {
+			return !this->data.empty();
+		});
+		result = move(data.front());
+		data.pop();
+	}
+
+	shared_ptr<value_type> waitPop() {
+		unique_lock<mutex> lock(m_mutex);
+		m_cv.wait(lock, [this]() {
+			return !this->data.empty();
+		});
+		const shared_ptr<value_type> res = make_shared<value_type>(move(data.front()));
+		data.pop();
+		return res;
+	}
+
+	value_type wait_pop() {
+		unique_lock<mutex> lock(m_mutex);
+		m_cv.wait(lock, [this]() {
+			return !this->data.empty();
+		});
+		value_type res(move_if_noexcept(data.front()));
+		data.pop();
+		return res;
+	}
+
+	bool tryPop(value_type& result) {
+		lock_guard<mutex> lock(m_mutex);
+		if (data.empty()) {
+			return false;
+		}
+		result = move(data.front());
+		data.pop();
+		return true;
+	}
+
+	shared_ptr<value_type> tryPop() {
+		lock_guard<mutex> lock(m_mutex);
+		if (data.empty()) {
+			return shared_ptr<value_type>();
+		}
+		shared_ptr<value_type> res = make_shared<value_type>(move(data.front()));
+		data.pop();
+		return res;
+	}
+
+	optional<value_type> try_pop() {
+		lock_guard<mutex> lock(m_mutex);
+		if (data.empty()) {
+			return nullopt;
+		}
+		optional<value_type> res(move_if_noexcept(data.front()));
+		data.pop();
+		return res;
+	}
+
+	bool empty() {
+		lock_guard<mutex> lock(m_mutex);
+		return data.empty();
+	}
+};
+
+#endif
@@ -1,53 +1,35 @@
-#include <iostream>
-#include <mutex>
+#include "ThreadSafe_queue_better.h"
 
-using namespace std;
-
-template <typename value_type>
-class ThreadSafe_queue {
-private:
-	struct Node {
-		shared_ptr<value_type> data;
-		unique_ptr<Node> next;
-	};
-	mutex m_headMutex;
-	mutex m_tailMutex;
-	unique_ptr<Node> head;
-	Node* tail;
-
-	Node* getTail() {
-		lock_guard<mutex> lock(m_tailMutex);
-		return tail;
-	}
-
-	unique_ptr<Node> popHead() {
-		lock_guard<mutex> lock(m_headMutex);
-		if (head.get() == tail) {
-			return nullptr;
+int main() {
+	ThreadSafe_queue_better<int, pool_allocator<int>> t_queue;
+	thread producer([&]() {
+		for (int i = 0; i < 100000; ++i) {
+			t_queue.push(i);
 		}
-		auto oldHead = move(head);
-		head = move(oldHead->next);
-		return oldHead;
-	}
-
-public:
-	ThreadSafe_queue():
-		head(new Node), tail(head.get()) {}
-	ThreadSafe_queue(const ThreadSafe_queue&) = delete;
-	ThreadSafe_queue& operator=(const ThreadSafe_queue&) = delete;
-
-	shared_ptr<value_type> tryPop() {
-		auto oldHead = popHead();
-		return oldHead ? oldHead->data : shared_ptr<value_type>();
-	}
+	});
+	thread consumer([&]() {
+		long long total = 0;
+		for (int popped = 0; popped < 100000;) {
+			if (auto value = t_queue.tryPop()) {
+				total += *value;
+				++popped;
+			}
+		}
+		cout << total << endl;
+	});
+	producer.join();
+	consumer.join();
 
-	void push(value_type result) {
-		auto newData = make_shared<value_type>(move(result));
-		unique_ptr<value_type> p(new Node);
-		Node* const newTail = p.get();
-		lock_guard<mutex> lock(m_tailMutex);
-		tail->data = newData;
-		tail->next = move(p);
-		tail = newTail;
-	}
-};
+	// move-only values go through emplace and come back by value.
+	ThreadSafe_queue_better<unique_ptr<int>> owners;
+	thread waiter([&]() {
+		unique_ptr<int> first = owners.wait_pop();
+		unique_ptr<int> second = owners.wait_pop();
+		cout << *first << " " << *second << endl;
+	});
+	owners.emplace(new int(1));
+	owners.push(make_unique<int>(2));
+	waiter.join();
+	cout << "empty: " << boolalpha << owners.empty() << ", try_pop: " << bool(owners.try_pop()) << endl;
+	return 0;
+}
@@ -0,0 +1,136 @@
+#ifndef THREADSAFE_QUEUE_BETTER
+#define THREADSAFE_QUEUE_BETTER
+
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include "../ch7/node_pool.h"
+
+using namespace std;
+
+/**
+ * Two-lock queue: push() only takes the tail lock, the pops only the head
+ * lock (and the tail lock for a moment, to compare against the dummy node).
+ * Values live in the nodes, so an item costs one node allocation.
+ */
+template <typename value_type, typename Alloc = allocator<value_type>>
+class ThreadSafe_queue_better {
+private:
+	struct Node {
+		typedef typename allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator;
+
+		// empty in the dummy node at the tail.
+		optional<value_type> data;
+		unique_ptr<Node> next;
+
+		// nodes come from the container's allocator, so unique_ptr<Node> keeps its default deleter.
+		static void* operator new(size_t) {
+			node_allocator alloc;
+			return allocator_traits<node_allocator>::allocate(alloc, 1);
+		}
+		static void operator delete(void* p) {
+			node_allocator alloc;
+			allocator_traits<node_allocator>::deallocate(alloc, static_cast<Node*>(p), 1);
+		}
+	};
+	mutex m_headMutex;
+	mutex m_tailMutex;
+	condition_variable m_cv;
+	// consumers inside wait_pop; pushers only touch the head lock when there are some.
+	atomic<unsigned> m_waiters{0};
+	unique_ptr<Node> head;
+	Node* tail;
+
+	Node* getTail() {
+		lock_guard<mutex> lock(m_tailMutex);
+		return tail;
+	}
+
+	// called with m_headMutex held.
+	void unlinkHead() {
+		unique_ptr<Node> oldHead = move(head);
+		head = move(oldHead->next);
+	}
+
+	template <typename... Args>
+	void pushValue(Args&&... args) {
+		unique_ptr<Node> p(new Node);
+		Node* const newTail = p.get();
+		{
+			lock_guard<mutex> lock(m_tailMutex);
+			// a throwing constructor leaves the queue as it was.
+			tail->data.emplace(forward<Args>(args)...);
+			tail->next = move(p);
+			tail = newTail;
+		}
+		// a waiter registers before it reads the tail under m_tailMutex, so it is
+		// counted here or it has seen the new tail. Taking the head lock makes
+		// sure it is blocked in wait() before the notify.
+		if (m_waiters.load(memory_order_acquire) != 0) {
+			lock_guard<mutex> lock(m_headMutex);
+			m_cv.notify_one();
+		}
+	}
+
+public:
+	ThreadSafe_queue_better():
+		head(new Node), tail(head.get()) {}
+	ThreadSafe_queue_better(const ThreadSafe_queue_better&) = delete;
+	ThreadSafe_queue_better& operator=(const ThreadSafe_queue_better&) = delete;
+
+	void push(value_type value) {
+		pushValue(move(value));
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		pushValue(forward<Args>(args)...);
+	}
+
+	shared_ptr<value_type> tryPop() {
+		lock_guard<mutex> lock(m_headMutex);
+		if (head.get() == getTail()) {
+			return shared_ptr<value_type>();
+		}
+		shared_ptr<value_type> res = allocate_shared<value_type>(Alloc(), move(*head->data));
+		unlinkHead();
+		return res;
+	}
+
+	/**
+	 * The head is only unlinked once the result holds it,
+	 * so a throwing copy leaves the queue untouched.
+	 */
+	optional<value_type> try_pop() {
+		lock_guard<mutex> lock(m_headMutex);
+		if (head.get() == getTail()) {
+			return nullopt;
+		}
+		optional<value_type> res(move_if_noexcept(*head->data));
+		unlinkHead();
+		return res;
+	}
+
+	value_type wait_pop() {
+		unique_lock<mutex> lock(m_headMutex);
+		m_waiters.fetch_add(1, memory_order_relaxed);
+		m_cv.wait(lock, [this]() {
+			return head.get() != getTail();
+		});
+		m_waiters.fetch_sub(1, memory_order_relaxed);
+		value_type res(move_if_noexcept(*head->data));
+		unlinkHead();
+		return res;
+	}
+
+	bool empty() {
+		lock_guard<mutex> lock(m_headMutex);
+		return head.get() == getTail();
+	}
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef DISTRIBUTED_SHARED_MUTEX
+#define DISTRIBUTED_SHARED_MUTEX
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "../ch5/latch.h" // for spin_pause
+
+using namespace std;
+
+/**
+ * Reader-writer lock for read-mostly data, usable wherever shared_mutex is
+ * (unique_lock, shared_lock, lock_guard).
+ * shared_mutex counts its readers in one word, so every lock_shared() fights
+ * over the same cache line. Here every thread has a reader slot, on a cache
+ * line of its own, and readers only touch their slot while no writer is around.
+ *
+ * A writer raises its flag and waits for all slots to drain; readers that
+ * see the flag step back until it is gone, so writers are not starved but a
+ * steady stream of writers can hold readers off. Writing costs a pass over
+ * every slot, which is what makes this a lock for data that is mostly read.
+ *
+ * Threads get their slot round-robin on first use and keep it, so a thread
+ * that migrates between cores still unlocks the slot it locked. With more
+ * threads than slots, some share one; that is correct, only less scalable.
+ *
+ * Every slot is a cache line, so a lock costs 64 bytes per slot: 4 KB at the
+ * default of one slot per hardware thread on a 64-thread machine. Pass a
+ * smaller count where many locks are needed, e.g. one per hash bucket.
+ */
+class distributed_shared_mutex {
+private:
+	static unsigned const spins_before_yield = 64;
+
+	struct alignas(64) reader_slot {
+		atomic<unsigned> readers{0};
+	};
+
+	alignas(64) atomic<bool> m_writer{false};
+	unsigned const m_slotCount;
+	unique_ptr<reader_slot[]> m_slots;
+
+	// the same for every lock, each one maps it onto its own slots.
+	static unsigned threadIndex() {
+		static atomic<unsigned> next{0};
+		static thread_local unsigned const index = next.fetch_add(1, memory_order_relaxed);
+		return index;
+	}
+
+	reader_slot& localSlot() {
+		return m_slots[threadIndex() % m_slotCount];
+	}
+
+	static void backoff(unsigned& spins) {
+		if (++spins < spins_before_yield) {
+			spin_pause();
+		} else {
+			this_thread::yield();
+		}
+	}
+
+	bool tryEnter(reader_slot& slot) {
+		// seq_cst on both sides: either the writer sees this reader, or the reader sees the writer.
+		slot.readers.fetch_add(1, memory_order_seq_cst);
+		if (!m_writer.load(memory_order_seq_cst)) {
+			return true;
+		}
+		slot.readers.fetch_sub(1, memory_order_release);
+		return false;
+	}
+
+	void waitForReaders() {
+		for (unsigned i = 0; i < m_slotCount; ++i) {
+			reader_slot& slot = m_slots[i];
+			unsigned spins = 0;
+			while (slot.readers.load(memory_order_seq_cst) != 0) {
+				backoff(spins);
+			}
+		}
+	}
+
+public:
+	explicit distributed_shared_mutex(unsigned slots = max(1u, thread::hardware_concurrency())) :
+		m_slotCount(max(1u, slots)), m_slots(new reader_slot[m_slotCount]) {}
+	distributed_shared_mutex(distributed_shared_mutex const&) = delete;
+	distributed_shared_mutex& operator=(distributed_shared_mutex const&) = delete;
+
+	void lock() {
+		unsigned spins = 0;
+		while (m_writer.load(memory_order_relaxed) || m_writer.exchange(true, memory_order_seq_cst)) {
+			backoff(spins);
+		}
+		waitForReaders();
+	}
+
+	bool try_lock() {
+		if (m_writer.load(memory_order_relaxed) || m_writer.exchange(true, memory_order_seq_cst)) {
+			return false;
+		}
+		for (unsigned i = 0; i < m_slotCount; ++i) {
+			if (m_slots[i].readers.load(memory_order_seq_cst) != 0) {
+				m_writer.store(false, memory_order_release);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void unlock() {
+		m_writer.store(false, memory_order_release);
+	}
+
+	void lock_shared() {
+		reader_slot& slot = localSlot();
+		unsigned spins = 0;
+		while (!tryEnter(slot)) {
+			while (m_writer.load(memory_order_acquire)) {
+				backoff(spins);
+			}
+		}
+	}
+
+	bool try_lock_shared() {
+		return tryEnter(localSlot());
+	}
+
+	void unlock_shared() {
+		localSlot().readers.fetch_sub(1, memory_order_release);
+	}
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "flat_combining.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// every thread pushes its share and pops as much as it can; nothing may get lost.
+template <typename Adapter>
+void exercise(string const& name) {
+	Adapter container;
+	int const threadCount = 4;
+	int const perThread = 50000;
+	atomic<long long> poppedSum{0};
+	atomic<long> poppedCount{0};
+	vector<thread> threads;
+	for (int id = 0; id < threadCount; ++id) {
+		threads.push_back(thread([&, id]() {
+			long long sum = 0;
+			long count = 0;
+			for (int i = 0; i < perThread; ++i) {
+				container.push(id * perThread + i);
+				if (i % 2 == 0) {
+					if (optional<int> value = container.try_pop()) {
+						sum += *value;
+						++count;
+					}
+				}
+			}
+			poppedSum += sum;
+			poppedCount += count;
+		}));
+	}
+	for (auto& thd : threads) {
+		thd.join();
+	}
+	int value;
+	long long sum = poppedSum;
+	long count = poppedCount;
+	while (container.try_pop(value)) {
+		sum += value;
+		++count;
+	}
+	long long const n = (long long)threadCount * perThread;
+	cout << name << ": popped " << count << " of " << n << ", sums match: " << boolalpha
+		<< (sum == n * (n - 1) / 2) << ", empty: " << container.empty() << endl;
+}
+
+int main() {
+	exercise<flat_combining_stack<int>>("flat_combining_stack");
+	exercise<flat_combining_queue<int>>("flat_combining_queue");
+
+	flat_combining_queue<string> names;
+	names.emplace("first");
+	names.emplace(3, 'x');
+	cout << *names.try_pop() << " " << *names.try_pop() << endl;
+	return 0;
+}
@@ -0,0 +1,179 @@
+#ifndef FLAT_COMBINING
+#define FLAT_COMBINING
+
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <queue>
+#include <stack>
+#include <thread>
+#include <utility>
+#include "../ch5/latch.h" // for spin_pause
+#include "../ch8/per_thread_slots.h"
+
+using namespace std;
+
+// the element the next pop() removes.
+template <typename T, typename Sequence>
+T& fc_next(stack<T, Sequence>& data) {
+	return data.top();
+}
+
+template <typename T, typename Sequence>
+T& fc_next(queue<T, Sequence>& data) {
+	return data.front();
+}
+
+/**
+ * Flat combining over a sequential std::stack or std::queue.
+ * A thread writes its operation into its own slot and then tries to become
+ * the combiner. The combiner walks all slots and runs every pending
+ * operation on the container, so one thread touches the container for a
+ * whole batch while the others wait on their slot instead of passing a
+ * mutex, and the container's cache lines, between cores.
+ *
+ * Slots are per thread and per instance, and live as long as the adapter.
+ * An exception thrown by the container reaches the thread that asked for
+ * the operation.
+ */
+template <typename Container>
+class flat_combining {
+public:
+	typedef typename Container::value_type value_type;
+
+private:
+	enum : unsigned { idle, push_request, pop_request };
+
+	struct alignas(64) slot {
+		atomic<unsigned> request{idle};
+		optional<value_type> value;
+		exception_ptr error;
+		thread::id owner;
+		slot* next = nullptr;
+
+		explicit slot(thread::id owner_) : owner(owner_) {}
+	};
+
+	// passes over the slots per combining turn; later requests wait for the next combiner.
+	static unsigned const combine_passes = 4;
+	static unsigned const spins_before_yield = 64;
+
+	alignas(64) atomic<bool> m_combining{false};
+	per_thread_slots<slot> m_slots;
+	// only touched by the combiner.
+	alignas(64) Container m_data;
+
+	slot& local() {
+		return m_slots.local([]() {
+			return new slot(this_thread::get_id());
+		});
+	}
+
+	void serve(slot& s, unsigned request) {
+		try {
+			if (request == push_request) {
+				m_data.push(move(*s.value));
+				s.value.reset();
+			} else if (m_data.empty()) {
+				s.value.reset();
+			} else {
+				s.value.emplace(move_if_noexcept(fc_next(m_data)));
+				m_data.pop();
+			}
+		} catch (...) {
+			s.error = current_exception();
+		}
+		s.request.store(idle, memory_order_release);
+	}
+
+	void combine() {
+		for (unsigned pass = 0; pass < combine_passes; ++pass) {
+			bool served = false;
+			for (slot* s = m_slots.head(); s; s = s->next) {
+				unsigned const request = s->request.load(memory_order_acquire);
+				if (request != idle) {
+					serve(*s, request);
+					served = true;
+				}
+			}
+			if (!served) {
+				break;
+			}
+		}
+	}
+
+	// publishes the request and returns once some combiner has served it.
+	void execute(slot& s, unsigned request) {
+		s.request.store(request, memory_order_release);
+		unsigned spins = 0;
+		while (s.request.load(memory_order_acquire) != idle) {
+			if (!m_combining.load(memory_order_relaxed) && !m_combining.exchange(true, memory_order_acquire)) {
+				combine();
+				m_combining.store(false, memory_order_release);
+				// the slot was registered before the request, so the pass above saw it.
+				break;
+			}
+			if (++spins < spins_before_yield) {
+				spin_pause();
+			} else {
+				this_thread::yield();
+			}
+		}
+		if (s.error) {
+			exception_ptr error = move(s.error);
+			s.error = nullptr;
+			rethrow_exception(error);
+		}
+	}
+
+public:
+	flat_combining() {}
+	flat_combining(flat_combining const&) = delete;
+	flat_combining& operator=(flat_combining const&) = delete;
+
+	void push(value_type value) {
+		slot& s = local();
+		s.value.emplace(move(value));
+		execute(s, push_request);
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		push(value_type(forward<Args>(args)...));
+	}
+
+	optional<value_type> try_pop() {
+		slot& s = local();
+		execute(s, pop_request);
+		optional<value_type> result(move(s.value));
+		s.value.reset();
+		return result;
+	}
+
+	bool try_pop(value_type& result) {
+		optional<value_type> value = try_pop();
+		if (!value) {
+			return false;
+		}
+		result = move(*value);
+		return true;
+	}
+
+	// only a snapshot while other threads are pushing or popping.
+	bool empty() {
+		while (m_combining.exchange(true, memory_order_acquire)) {
+			this_thread::yield();
+		}
+		bool const result = m_data.empty();
+		m_combining.store(false, memory_order_release);
+		return result;
+	}
+};
+
+template <typename value_type>
+using flat_combining_stack = flat_combining<stack<value_type>>;
+
+template <typename value_type>
+using flat_combining_queue = flat_combining<queue<value_type>>;
+
+#endif
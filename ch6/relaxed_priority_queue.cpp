@@ -0,0 +1,56 @@
+#include "relaxed_priority_queue.h"
+
+#include <iostream>
+#include <iterator>
+#include <set>
+
+using namespace std;
+
+/**
+ * Pops everything one thread pushed and measures how far each pop
+ * was from the true best element at that moment.
+ */
+double averageRankError(relaxed_priority_queue<int, int>& queue, int count) {
+	vector<int> keys(count);
+	for (int i = 0; i < count; ++i) {
+		keys[i] = (i * 7919) % count;
+		queue.push(keys[i], i);
+	}
+	multiset<int, greater<int>> remaining(keys.begin(), keys.end());
+	long long totalRank = 0;
+	while (auto entry = queue.try_pop()) {
+		auto it = remaining.find(entry->first);
+		totalRank += distance(remaining.begin(), it);
+		remaining.erase(it);
+	}
+	return double(totalRank) / count;
+}
+
+int main() {
+	relaxed_priority_queue<int, int> strictQueue(1);
+	relaxed_priority_queue<int, int> relaxedQueue(16);
+	cout << "strict rank error: " << averageRankError(strictQueue, 5000) << endl;
+	cout << "16 heaps rank error: " << averageRankError(relaxedQueue, 5000) << endl;
+
+	relaxed_priority_queue<int, int> queue;
+	atomic<long long> popped{0};
+	vector<thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.push_back(thread([&, t]() {
+			for (int i = 0; i < 50000; ++i) {
+				queue.push(i, t);
+				if (i % 2 && queue.try_pop()) {
+					++popped;
+				}
+			}
+		}));
+	}
+	for (auto& thd : threads) {
+		thd.join();
+	}
+	while (queue.try_pop()) {
+		++popped;
+	}
+	cout << "popped " << popped << " of " << 4 * 50000 << endl;
+	return 0;
+}
@@ -0,0 +1,182 @@
+#ifndef RELAXED_PRIORITY_QUEUE
+#define RELAXED_PRIORITY_QUEUE
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * MultiQueue: many small locked heaps instead of one.
+ * push goes to a random heap; pop looks at the cached tops of two random
+ * heaps and takes from the better one. Nobody waits for a lock, a busy heap
+ * is simply skipped. The price is that pop returns a near-best element:
+ * the expected rank error grows with the number of heaps.
+ * With a single heap the queue is strict.
+ */
+template <typename Key, typename Value, typename Compare = less<Key>>
+class relaxed_priority_queue {
+private:
+	typedef pair<Key, Value> entry;
+
+	struct entry_compare {
+		Compare comp;
+		bool operator()(entry const& lhs, entry const& rhs) const {
+			return comp(lhs.first, rhs.first);
+		}
+	};
+
+	struct alignas(64) shard {
+		mutex m_mutex;
+		priority_queue<entry, vector<entry>, entry_compare> heap;
+		// read without the lock to pick a heap, only a hint.
+		atomic<bool> nonEmpty{false};
+		atomic<Key> top{};
+
+		void refreshTop() {
+			if (heap.empty()) {
+				nonEmpty.store(false, memory_order_relaxed);
+			} else {
+				top.store(heap.top().first, memory_order_relaxed);
+				nonEmpty.store(true, memory_order_release);
+			}
+		}
+	};
+
+	vector<unique_ptr<shard>> m_shards;
+	Compare m_comp;
+
+	static unsigned randomIndex(unsigned bound) {
+		static thread_local unsigned long long state =
+			0x9E3779B97F4A7C15ull ^ hash<thread::id>()(this_thread::get_id());
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state % bound;
+	}
+
+	bool strict() const {
+		return m_shards.size() == 1;
+	}
+
+	optional<entry> popFrom(shard& s) {
+		if (s.heap.empty()) {
+			return nullopt;
+		}
+		optional<entry> res(move_if_noexcept(const_cast<entry&>(s.heap.top())));
+		s.heap.pop();
+		s.refreshTop();
+		return res;
+	}
+
+public:
+	static_assert(is_trivially_copyable<Key>::value, "the cached top needs an atomic Key");
+
+	/**
+	 * shards == 1 gives a strict priority queue. The default of two heaps
+	 * per hardware thread keeps the expected rank error around the shard count.
+	 */
+	explicit relaxed_priority_queue(unsigned shards = 2 * max(1u, thread::hardware_concurrency()),
+			Compare comp = Compare()) : m_comp(comp) {
+		shards = max(1u, shards);
+		for (unsigned i = 0; i < shards; ++i) {
+			m_shards.emplace_back(new shard);
+			m_shards.back()->heap = priority_queue<entry, vector<entry>, entry_compare>(entry_compare{comp});
+		}
+	}
+	relaxed_priority_queue(relaxed_priority_queue const&) = delete;
+	relaxed_priority_queue& operator=(relaxed_priority_queue const&) = delete;
+
+	unsigned shards() const {
+		return m_shards.size();
+	}
+
+	void push(Key key, Value value) {
+		if (strict()) {
+			shard& s = *m_shards[0];
+			lock_guard<mutex> lock(s.m_mutex);
+			s.heap.emplace(move(key), move(value));
+			s.refreshTop();
+			return;
+		}
+		while (true) {
+			shard& s = *m_shards[randomIndex(m_shards.size())];
+			unique_lock<mutex> lock(s.m_mutex, try_to_lock);
+			if (lock.owns_lock()) {
+				s.heap.emplace(move(key), move(value));
+				s.refreshTop();
+				return;
+			}
+		}
+	}
+
+	/**
+	 * Empty only when every heap was seen empty, so a concurrent
+	 * push may be missed, as with any try_pop.
+	 */
+	optional<entry> try_pop() {
+		if (strict()) {
+			shard& s = *m_shards[0];
+			lock_guard<mutex> lock(s.m_mutex);
+			return popFrom(s);
+		}
+		unsigned const count = m_shards.size();
+		unsigned misses = 0;
+		while (true) {
+			shard* first = m_shards[randomIndex(count)].get();
+			shard* second = m_shards[randomIndex(count)].get();
+			bool const firstHas = first->nonEmpty.load(memory_order_acquire);
+			bool const secondHas = second->nonEmpty.load(memory_order_acquire);
+			shard* best = nullptr;
+			if (firstHas && secondHas) {
+				best = m_comp(first->top.load(memory_order_relaxed), second->top.load(memory_order_relaxed)) ? second : first;
+			} else if (firstHas) {
+				best = first;
+			} else if (secondHas) {
+				best = second;
+			}
+			if (best) {
+				unique_lock<mutex> lock(best->m_mutex, try_to_lock);
+				if (lock.owns_lock()) {
+					if (optional<entry> res = popFrom(*best)) {
+						return res;
+					}
+				}
+				continue;
+			}
+			// two empty picks in a row are common when nearly drained:
+			// walk all heaps and pop from the first one that has something.
+			if (++misses >= 2) {
+				misses = 0;
+				for (auto& s : m_shards) {
+					if (s->nonEmpty.load(memory_order_acquire)) {
+						lock_guard<mutex> lock(s->m_mutex);
+						if (optional<entry> res = popFrom(*s)) {
+							return res;
+						}
+					}
+				}
+				return nullopt;
+			}
+		}
+	}
+
+	bool empty() const {
+		for (auto const& s : m_shards) {
+			if (s->nonEmpty.load(memory_order_acquire)) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+#endif
@@ -2,25 +2,37 @@
 #include <mutex>
 #include <thread>
 #include <memory>
+#include "../ch7/node_pool.h"
 
 using namespace std;
 
-template <typename value_type>
+template <typename value_type, typename Alloc = allocator<value_type>>
 class threadSafe_list {
 private:
 	struct Node {
+		typedef typename allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator;
+
 		shared_ptr<value_type> data;
 		unique_ptr<Node> next; // make sure that only one ptr will point to next.
 		mutex m_mutex;
 		Node() : next() {}
-		Node(value_type const& value) : data(make_shared<value_type>(value)) {}
+		Node(value_type const& value) : data(allocate_shared<value_type>(Alloc(), value)) {}
+
+		static void* operator new(size_t) {
+			node_allocator alloc;
+			return allocator_traits<node_allocator>::allocate(alloc, 1);
+		}
+		static void operator delete(void* p) {
+			node_allocator alloc;
+			allocator_traits<node_allocator>::deallocate(alloc, static_cast<Node*>(p), 1);
+		}
 	};
 	Node head;
 
 public:
 	threadSafe_list() {}
 	~threadSafe_list() {
-		remove_if([](Node const&) { return true; });
+		remove_if([](value_type const&) { return true; });
 	}
 	threadSafe_list(threadSafe_list const&) = delete;
 	threadSafe_list& operator=(threadSafe_list const&) = delete;
@@ -50,7 +62,7 @@ public:
 		Node* current = &head;
 		unique_lock<mutex> now_lock(head.m_mutex);
 		while (Node* const next = current->next.get()) {
-			unique_lock<mutex> next_lock(next->mutex);
+			unique_lock<mutex> next_lock(next->m_mutex);
 			now_lock.unlock();
 			if (pred(*next->data)) {
 				return next->data;
@@ -81,7 +93,7 @@ public:
 };
 
 int main() {
-	threadSafe_list<int> list;
+	threadSafe_list<int, pool_allocator<int>> list;
 	thread a([&]() {
 		list.push_front(10);
 		list.push_front(20);
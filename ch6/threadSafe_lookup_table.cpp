@@ -1,13 +1,26 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
 #include <shared_mutex>
+#include <string>
 #include <mutex>
 #include <thread>
 #include <map>
 #include <vector>
 #include <list>
+#include "distributed_shared_mutex.h"
 
 using namespace std;
 
-template <typename Key, typename Value, typename Hash = hash<Key>>
+/**
+ * Mutex guards each bucket: shared_mutex, or distributed_shared_mutex
+ * for read-mostly tables where lookups should scale with the cores.
+ * The latter takes a cache line per hardware thread in every bucket,
+ * e.g. 19 buckets of 64 slots come to about 80 KB of locks.
+ */
+template <typename Key, typename Value, typename Hash = hash<Key>, typename Mutex = shared_mutex>
 class threadSafe_lookup_table {
 private:
 	class bucket_type {
@@ -15,34 +28,41 @@ private:
 		typedef pair<Key, Value> bucket_value;
 		typedef list<bucket_value> bucket_data;
 		typedef typename bucket_data::iterator bucket_iterator;
+		typedef typename bucket_data::const_iterator bucket_const_iterator;
 
 		bucket_data data;
-		mutable shared_mutex m_mutex;
+		mutable Mutex m_mutex;
 
-		bucket_iterator find_entry_for(Key const& key) const {
-			return find_if(data.begin(), data.end(), [&](bucket_value& item) {
-				return item->first == key;
+		bucket_const_iterator find_entry_for(Key const& key) const {
+			return find_if(data.begin(), data.end(), [&](bucket_value const& item) {
+				return item.first == key;
+			});
+		}
+
+		bucket_iterator find_entry_for(Key const& key) {
+			return find_if(data.begin(), data.end(), [&](bucket_value const& item) {
+				return item.first == key;
 			});
 		}
 	public:
 		Value value_for(Key const& key, Value const& default_value) const {
-			shared_lock<shared_mutex> lock(m_mutex);
+			shared_lock<Mutex> lock(m_mutex);
 			auto entry_iterator = find_entry_for(key);
 			return entry_iterator == data.end() ? default_value : entry_iterator->second;
 		}
 
 		void add_or_update_mapping(Key const& key, Value const& newValue) {
-			unique_lock<shared_mutex> lock(m_mutex);
+			unique_lock<Mutex> lock(m_mutex);
 			auto entry_iterator = find_entry_for(key);
-			if (key == data.end()) {
-				data.push_back(bucket_type(key, newValue));
+			if (entry_iterator == data.end()) {
+				data.push_back(bucket_value(key, newValue));
 			} else {
-				entry_iterator->second = value;
+				entry_iterator->second = newValue;
 			}
 		}
 
 		void remove_mapping(Key const& key) {
-			unique_lock<shared_mutex> lock(m_mutex);
+			unique_lock<Mutex> lock(m_mutex);
 			auto entry_iterator = find_entry_for(key);
 			if (entry_iterator != data.end()) {
 				data.erase(entry_iterator);
@@ -52,22 +72,22 @@ private:
 
 	vector<unique_ptr<bucket_type>> buckets;
 	Hash hasher;
-	bucket_type& get_bucket(Key& const key) {
+	bucket_type& get_bucket(Key const& key) const {
 		return *buckets[hasher(key) % buckets.size()];
 	}
 
 public:
 	threadSafe_lookup_table(unsigned num_buckets = 19, Hash hasher_ = Hash())
 		: buckets(num_buckets), hasher(hasher_) {
-			for (int i = 0; i < num_buckets; ++i) {
+			for (unsigned i = 0; i < num_buckets; ++i) {
 				buckets[i].reset(new bucket_type);
 			}
 		}
 	threadSafe_lookup_table& operator=(threadSafe_lookup_table const&) = delete;
 	threadSafe_lookup_table(threadSafe_lookup_table const&) = delete;
 
-	Value value_for(Key const& key, Value const& default_value) {
-	 	return get_bucket(key).value_for(key, default_value);
+	Value value_for(Key const& key, Value const& default_value) const {
+		return get_bucket(key).value_for(key, default_value);
 	}
 
 	void add_or_update_mapping(Key const& key, Value const& newValue) {
@@ -79,6 +99,49 @@ public:
 	}
 };
 
+// read-mostly load: one lookup in a hundred is replaced by an update.
+template <typename Mutex>
+void measure(char const* name, unsigned threadCount) {
+	threadSafe_lookup_table<int, int, hash<int>, Mutex> table;
+	int const keys = 1000;
+	for (int key = 0; key < keys; ++key) {
+		table.add_or_update_mapping(key, key);
+	}
+	int const perThread = 200000;
+	atomic<long> misses{0};
+	auto start = chrono::steady_clock::now();
+	vector<thread> threads;
+	for (unsigned id = 0; id < threadCount; ++id) {
+		threads.push_back(thread([&table, &misses, id]() {
+			long missed = 0;
+			for (int i = 0; i < perThread; ++i) {
+				int const key = int((i * 7919u + id) % keys);
+				if (i % 100 == 0) {
+					table.add_or_update_mapping(key, key);
+				} else if (table.value_for(key, -1) != key) {
+					++missed;
+				}
+			}
+			misses += missed;
+		}));
+	}
+	for (auto& thd : threads) {
+		thd.join();
+	}
+	double const ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << name << ", " << threadCount << " threads: " << ms << " ms, wrong values " << misses << endl;
+}
+
 int main() {
+	unsigned const threadCount = max(2u, thread::hardware_concurrency());
+	measure<shared_mutex>("shared_mutex", threadCount);
+	measure<distributed_shared_mutex>("distributed_shared_mutex", threadCount);
 
+	threadSafe_lookup_table<string, int, hash<string>, distributed_shared_mutex> ages;
+	ages.add_or_update_mapping("alice", 30);
+	ages.add_or_update_mapping("alice", 31);
+	ages.add_or_update_mapping("bob", 25);
+	ages.remove_mapping("bob");
+	cout << "alice " << ages.value_for("alice", 0) << ", bob " << ages.value_for("bob", 0) << endl;
+	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef THREADSAFE_STACK
+#define THREADSAFE_STACK
+
+#include <thread>
+#include <mutex>
+#include <stack>
+#include <iostream>
+#include <exception>
+#include <memory>
+#include <optional>
+
+using namespace std;
+
+struct empty_stack: exception {
+	const char* what() const throw();
+};
+
+template <typename value_type>
+class ThreadSafe_stack {
+private:
+	stack<value_type> data;
+	mutable mutex m_mutex;
+
+public:
+	ThreadSafe_stack() {}
+	ThreadSafe_stack(const ThreadSafe_stack& other) {
+		lock_guard<mutex> lock(other.m_mutex);
+		data = other.data;
+	}
+	ThreadSafe_stack& operator=(const ThreadSafe_stack& other) = delete;
+
+	void push(value_type value) {
+		lock_guard<mutex> lock(m_mutex);
+		data.push(move(value));
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		lock_guard<mutex> lock(m_mutex);
+		data.emplace(forward<Args>(args)...);
+	}
+
+	void pop(value_type& result) {
+		lock_guard<mutex> lock(m_mutex);
+		if (data.empty()) {
+			// throw empty_stack();
+		}
+		result = move(data.top());
+		data.pop();
+	}
+
+	shared_ptr<value_type> pop() {
+		lock_guard<mutex> lock(m_mutex);
+		if (data.empty()) {
+			// throw empty_stack();
+		}
+		const shared_ptr<value_type> res = make_shared<value_type>(move(data.top()));
+		data.pop();
+		return res;
+	}
+
+	optional<value_type> try_pop() {
+		lock_guard<mutex> lock(m_mutex);
+		if (data.empty()) {
+			return nullopt;
+		}
+		optional<value_type> res(move_if_noexcept(data.top()));
+		data.pop();
+		return res;
+	}
+
+	bool empty() {
+		lock_guard<mutex> lock(m_mutex);
+		return data.empty();
+	}
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "unrolled_threadSafe_list.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "../ch7/node_pool.h"
+
+using namespace std;
+
+int main() {
+	unrolled_threadSafe_list<int, pool_allocator<int>> list;
+	int const threadCount = 4;
+	int const perThread = 250000;
+	vector<thread> threads;
+	for (int id = 0; id < threadCount; ++id) {
+		threads.push_back(thread([&list, id]() {
+			for (int i = 0; i < perThread; ++i) {
+				list.push_front(id * perThread + i);
+			}
+		}));
+	}
+	// a reader and a remover racing the writers.
+	threads.push_back(thread([&list]() {
+		long visited = 0;
+		list.for_each([&visited](int) {
+			++visited;
+		});
+		cout << "reader visited " << visited << " values while the writers were busy" << endl;
+	}));
+	threads.push_back(thread([&list]() {
+		list.remove_if([](int value) {
+			return value % 1000 == 0;
+		});
+	}));
+	for (auto& thd : threads) {
+		thd.join();
+	}
+
+	auto start = chrono::steady_clock::now();
+	long count = 0;
+	long long sum = 0;
+	list.for_each([&](int value) {
+		++count;
+		sum += value;
+	});
+	double const ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "for_each over " << count << " values took " << ms << " ms" << endl;
+
+	// remove the rest of the multiples of 1000, whichever got in after the remover.
+	list.remove_if([](int value) {
+		return value % 1000 == 0;
+	});
+	long remaining = 0;
+	bool multiples = false;
+	list.for_each([&](int value) {
+		++remaining;
+		multiples = multiples || value % 1000 == 0;
+	});
+	long const expected = long(threadCount) * perThread - long(threadCount) * perThread / 1000;
+	cout << "after remove_if: " << remaining << " values, expected " << expected
+		<< ", multiples of 1000 left: " << boolalpha << multiples << endl;
+
+	shared_ptr<int> found = list.find_first_if([](int value) {
+		return value > 999990;
+	});
+	cout << "first value above 999990: " << (found ? to_string(*found) : "none") << endl;
+	return 0;
+}
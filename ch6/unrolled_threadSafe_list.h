@@ -0,0 +1,176 @@
+#ifndef UNROLLED_THREADSAFE_LIST
+#define UNROLLED_THREADSAFE_LIST
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+using namespace std;
+
+// values per node: about 256 bytes of them, and at least 4.
+template <typename value_type>
+constexpr size_t unrolled_node_capacity() {
+	return max<size_t>(4, 256 / sizeof(value_type));
+}
+
+/**
+ * threadSafe_list with many values in each node.
+ * Every node keeps up to node_capacity values inline and one mutex for all
+ * of them, so storing an element costs no allocation of its own, and a
+ * traversal takes one lock and a few cache lines per node_capacity elements.
+ *
+ * The locking is the same hand-over-hand scheme: a thread holds the lock of
+ * the node it is in, and takes the next one before letting go of it.
+ * for_each and find_first_if see the values newest first, as in threadSafe_list;
+ * remove_if keeps the order of the rest and frees nodes that become empty.
+ * find_first_if returns a copy of the value, there is no per-element shared_ptr
+ * left to alias.
+ */
+template <typename value_type, typename Alloc = allocator<value_type>,
+	size_t node_capacity = unrolled_node_capacity<value_type>()>
+class unrolled_threadSafe_list {
+private:
+	struct Node;
+
+	struct Link {
+		mutex m_mutex;
+		unique_ptr<Node> next;
+	};
+
+	struct Node : Link {
+		typedef typename allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator;
+
+		size_t count = 0;
+		// values[count - 1] is the newest.
+		alignas(value_type) unsigned char storage[node_capacity * sizeof(value_type)];
+
+		Node() {}
+		~Node() {
+			for (size_t i = 0; i < count; ++i) {
+				value(i).~value_type();
+			}
+		}
+
+		value_type& value(size_t i) {
+			return *launder(reinterpret_cast<value_type*>(storage) + i);
+		}
+
+		static void* operator new(size_t) {
+			node_allocator alloc;
+			return allocator_traits<node_allocator>::allocate(alloc, 1);
+		}
+		static void operator delete(void* p) {
+			node_allocator alloc;
+			allocator_traits<node_allocator>::deallocate(alloc, static_cast<Node*>(p), 1);
+		}
+	};
+
+	Link head;
+
+public:
+	unrolled_threadSafe_list() {}
+	~unrolled_threadSafe_list() {
+		// one node at a time, a long chain of unique_ptr would recurse.
+		unique_ptr<Node> node = move(head.next);
+		while (node) {
+			node = move(node->next);
+		}
+	}
+	unrolled_threadSafe_list(unrolled_threadSafe_list const&) = delete;
+	unrolled_threadSafe_list& operator=(unrolled_threadSafe_list const&) = delete;
+
+	void push_front(value_type const& value) {
+		lock_guard<mutex> head_lock(head.m_mutex);
+		if (Node* const first = head.next.get()) {
+			lock_guard<mutex> first_lock(first->m_mutex);
+			if (first->count < node_capacity) {
+				new (first->storage + first->count * sizeof(value_type)) value_type(value);
+				++first->count;
+				return;
+			}
+		}
+		// only every node_capacity-th push gets here, when the first node is full.
+		unique_ptr<Node> new_node(new Node);
+		new (new_node->storage) value_type(value);
+		new_node->count = 1;
+		new_node->next = move(head.next);
+		head.next = move(new_node);
+	}
+
+	template <typename Function>
+	void for_each(Function func) {
+		Link* current = &head;
+		unique_lock<mutex> now_lock(head.m_mutex);
+		while (Node* const next = current->next.get()) {
+			unique_lock<mutex> next_lock(next->m_mutex);
+			now_lock.unlock();
+			for (size_t i = next->count; i-- > 0;) {
+				func(next->value(i));
+			}
+			current = next;
+			now_lock = move(next_lock);
+		}
+	}
+
+	template <typename Predicate>
+	shared_ptr<value_type> find_first_if(Predicate pred) {
+		Link* current = &head;
+		unique_lock<mutex> now_lock(head.m_mutex);
+		while (Node* const next = current->next.get()) {
+			unique_lock<mutex> next_lock(next->m_mutex);
+			now_lock.unlock();
+			for (size_t i = next->count; i-- > 0;) {
+				if (pred(next->value(i))) {
+					return allocate_shared<value_type>(Alloc(), next->value(i));
+				}
+			}
+			current = next;
+			now_lock = move(next_lock);
+		}
+		return shared_ptr<value_type>();
+	}
+
+	template <typename Predicate>
+	void remove_if(Predicate pred) {
+		Link* current = &head;
+		unique_lock<mutex> now_lock(head.m_mutex);
+		while (Node* const next = current->next.get()) {
+			unique_lock<mutex> next_lock(next->m_mutex);
+			// decide for the whole node first, so a throwing pred leaves it untouched.
+			bool remove[node_capacity];
+			bool any = false;
+			for (size_t i = 0; i < next->count; ++i) {
+				remove[i] = pred(next->value(i));
+				any = any || remove[i];
+			}
+			if (any) {
+				size_t kept = 0;
+				for (size_t i = 0; i < next->count; ++i) {
+					if (remove[i]) {
+						next->value(i).~value_type();
+					} else {
+						if (kept != i) {
+							new (next->storage + kept * sizeof(value_type)) value_type(move(next->value(i)));
+							next->value(i).~value_type();
+						}
+						++kept;
+					}
+				}
+				next->count = kept;
+			}
+			if (next->count == 0) {
+				unique_ptr<Node> old_next = move(current->next);
+				current->next = move(next->next);
+				next_lock.unlock();
+			} else {
+				now_lock.unlock();
+				current = next;
+				now_lock = move(next_lock);
+			}
+		}
+	}
+};
+
+#endif
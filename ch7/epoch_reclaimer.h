@@ -0,0 +1,197 @@
+#ifndef EPOCH_RECLAIMER
+#define EPOCH_RECLAIMER
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Epoch based reclamation for lock-free structures.
+ * A thread enters a critical section (epoch_guard) before it touches shared
+ * nodes and announces the global epoch it saw. A node unlinked in epoch e is
+ * retired, and freed once the epoch has moved on to e + 2: by then every
+ * thread that could have reached the node has left its critical section.
+ * The epoch only moves on when every thread inside one has seen the current epoch.
+ *
+ * Unlike threads_in_pop in free_lock_stack, readers never have to drain to
+ * zero for memory to come back, and they write only their own slot.
+ */
+class epoch_reclaimer {
+private:
+	struct alignas(64) participant {
+		atomic<unsigned long> epoch{0};
+		atomic<bool> active{false};
+		atomic<bool> in_use{true};
+		participant* next = nullptr;
+	};
+
+	struct retired {
+		void* pointer;
+		void (*deleter)(void*);
+		unsigned long epoch;
+	};
+
+	struct thread_state {
+		participant* self = nullptr;
+		unsigned nesting = 0;
+		vector<retired> limbo;
+
+		~thread_state() {
+			if (self) {
+				instance().orphan(limbo);
+				self->in_use.store(false, memory_order_release);
+			}
+		}
+	};
+
+	static unsigned const collect_threshold = 64;
+
+	atomic<unsigned long> m_epoch{0};
+	atomic<participant*> m_participants{nullptr};
+	mutex m_orphanMutex;
+	vector<retired> m_orphans;
+
+	epoch_reclaimer() {}
+
+	~epoch_reclaimer() {
+		for (retired& r : m_orphans) {
+			r.deleter(r.pointer);
+		}
+		participant* p = m_participants.load();
+		while (p) {
+			participant* next = p->next;
+			delete p;
+			p = next;
+		}
+	}
+
+	// slots of exited threads are reused, so the list only grows to the peak thread count.
+	participant* join() {
+		for (participant* p = m_participants.load(memory_order_acquire); p; p = p->next) {
+			bool expected = false;
+			if (!p->in_use.load(memory_order_relaxed) &&
+				p->in_use.compare_exchange_strong(expected, true, memory_order_acquire)) {
+				return p;
+			}
+		}
+		participant* p = new participant;
+		p->next = m_participants.load(memory_order_relaxed);
+		while (!m_participants.compare_exchange_weak(p->next, p, memory_order_release, memory_order_relaxed));
+		return p;
+	}
+
+	thread_state& local() {
+		static thread_local thread_state state;
+		if (!state.self) {
+			state.self = join();
+		}
+		return state;
+	}
+
+	bool tryAdvance() {
+		unsigned long const epoch = m_epoch.load(memory_order_seq_cst);
+		for (participant* p = m_participants.load(memory_order_acquire); p; p = p->next) {
+			if (p->active.load(memory_order_seq_cst) && p->epoch.load(memory_order_seq_cst) != epoch) {
+				return false;
+			}
+		}
+		unsigned long expected = epoch;
+		return m_epoch.compare_exchange_strong(expected, epoch + 1, memory_order_acq_rel);
+	}
+
+	static void freeExpired(vector<retired>& list, unsigned long epoch) {
+		size_t kept = 0;
+		for (size_t i = 0; i < list.size(); ++i) {
+			if (list[i].epoch + 2 <= epoch) {
+				list[i].deleter(list[i].pointer);
+			} else {
+				list[kept++] = list[i];
+			}
+		}
+		list.resize(kept);
+	}
+
+	void collect(thread_state& state) {
+		tryAdvance();
+		unsigned long const epoch = m_epoch.load(memory_order_acquire);
+		freeExpired(state.limbo, epoch);
+		unique_lock<mutex> lock(m_orphanMutex, try_to_lock);
+		if (lock.owns_lock()) {
+			freeExpired(m_orphans, epoch);
+		}
+	}
+
+	void orphan(vector<retired>& limbo) {
+		lock_guard<mutex> lock(m_orphanMutex);
+		m_orphans.insert(m_orphans.end(), limbo.begin(), limbo.end());
+		limbo.clear();
+	}
+
+public:
+	static epoch_reclaimer& instance() {
+		static epoch_reclaimer reclaimer;
+		return reclaimer;
+	}
+
+	void enter() {
+		thread_state& state = local();
+		if (state.nesting++ != 0) {
+			return;
+		}
+		participant& self = *state.self;
+		unsigned long epoch = m_epoch.load(memory_order_seq_cst);
+		self.epoch.store(epoch, memory_order_seq_cst);
+		// seq_cst orders the announcement before the epoch is checked again
+		// and before any shared node is read.
+		self.active.store(true, memory_order_seq_cst);
+		unsigned long current;
+		while ((current = m_epoch.load(memory_order_seq_cst)) != epoch) {
+			epoch = current;
+			self.epoch.store(epoch, memory_order_seq_cst);
+		}
+	}
+
+	void leave() {
+		thread_state& state = local();
+		if (--state.nesting == 0) {
+			state.self->active.store(false, memory_order_release);
+		}
+	}
+
+	// p must already be unreachable for threads entering from now on.
+	template <typename T>
+	void retire(T* p) {
+		retire(p, [](void* q) {
+			delete static_cast<T*>(q);
+		});
+	}
+
+	void retire(void* p, void (*deleter)(void*)) {
+		thread_state& state = local();
+		state.limbo.push_back({p, deleter, m_epoch.load(memory_order_acquire)});
+		if (state.limbo.size() >= collect_threshold) {
+			collect(state);
+		}
+	}
+};
+
+// keep it alive for as long as nodes reached through the structure are used.
+class epoch_guard {
+public:
+	epoch_guard() {
+		epoch_reclaimer::instance().enter();
+	}
+	epoch_guard(epoch_guard const&) {
+		epoch_reclaimer::instance().enter();
+	}
+	epoch_guard& operator=(epoch_guard const&) {
+		return *this;
+	}
+	~epoch_guard() {
+		epoch_reclaimer::instance().leave();
+	}
+};
+
+#endif
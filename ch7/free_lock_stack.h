@@ -0,0 +1,106 @@
+#ifndef FREE_LOCK_STACK
+#define FREE_LOCK_STACK
+
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "node_pool.h"
+using namespace std;
+
+template <typename value_type, typename Alloc = allocator<value_type>>
+class free_lock_stack {
+private:
+	struct Node {
+		typedef typename allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator;
+
+		shared_ptr<value_type> data;
+		Node* next;
+
+		Node(value_type const& new_value) :
+			data(allocate_shared<value_type>(Alloc(), new_value)), next(nullptr) {}
+
+		static void* operator new(size_t) {
+			node_allocator alloc;
+			return allocator_traits<node_allocator>::allocate(alloc, 1);
+		}
+		static void operator delete(void* p) {
+			node_allocator alloc;
+			allocator_traits<node_allocator>::deallocate(alloc, static_cast<Node*>(p), 1);
+		}
+	};
+	atomic<Node*> head{nullptr};
+	/**
+	 * A popped node can only be freed once no other pop() may still be reading it,
+	 * otherwise it would be handed out again by the allocator under their feet.
+	 */
+	atomic<unsigned> threads_in_pop{0};
+	atomic<Node*> to_be_deleted{nullptr};
+
+	static void delete_nodes(Node* nodes) {
+		while (nodes) {
+			Node* next = nodes->next;
+			delete nodes;
+			nodes = next;
+		}
+	}
+
+	void chain_pending_nodes(Node* first, Node* last) {
+		last->next = to_be_deleted.load();
+		while (!to_be_deleted.compare_exchange_weak(last->next, first));
+	}
+
+	void chain_pending_nodes(Node* nodes) {
+		Node* last = nodes;
+		while (Node* const next = last->next) {
+			last = next;
+		}
+		chain_pending_nodes(nodes, last);
+	}
+
+	void try_reclaim(Node* old_head) {
+		if (threads_in_pop == 1) {
+			Node* nodes_to_delete = to_be_deleted.exchange(nullptr);
+			if (!--threads_in_pop) {
+				delete_nodes(nodes_to_delete);
+			} else if (nodes_to_delete) {
+				chain_pending_nodes(nodes_to_delete);
+			}
+			delete old_head;
+		} else {
+			chain_pending_nodes(old_head, old_head);
+			--threads_in_pop;
+		}
+	}
+
+public:
+	free_lock_stack() {}
+	free_lock_stack(free_lock_stack const&) = delete;
+	free_lock_stack& operator=(free_lock_stack const&) = delete;
+	~free_lock_stack() {
+		delete_nodes(head.load());
+		delete_nodes(to_be_deleted.load());
+	}
+
+	void push(value_type const& new_value) {
+		Node* const new_node = new Node(new_value);
+		new_node->next = head.load();
+		while (!head.compare_exchange_weak(new_node->next, new_node));
+	}
+
+	shared_ptr<value_type> pop() {
+		++threads_in_pop;
+		Node* old_head = head.load();
+		while (old_head && !head.compare_exchange_weak(old_head, old_head->next));
+		shared_ptr<value_type> res;
+		if (!old_head) {
+			--threads_in_pop;
+			return res;
+		}
+		res.swap(old_head->data);
+		try_reclaim(old_head);
+		return res;
+	}
+};
+
+#endif
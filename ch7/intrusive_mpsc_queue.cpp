@@ -0,0 +1,60 @@
+#include "intrusive_mpsc_queue.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// the queue link is part of the message, so pushing allocates nothing.
+struct message : mpsc_node {
+	int source;
+	int sequence;
+};
+
+int main() {
+	int const producers = 4;
+	int const perProducer = 100000;
+	// each producer owns its messages; they stay alive until main returns.
+	vector<vector<message>> messages;
+	for (int id = 0; id < producers; ++id) {
+		messages.emplace_back(perProducer);
+	}
+	intrusive_mpsc_queue<message> queue;
+
+	vector<thread> threads;
+	for (int id = 0; id < producers; ++id) {
+		threads.push_back(thread([&messages, &queue, id]() {
+			for (int i = 0; i < perProducer; ++i) {
+				message& e = messages[id][i];
+				e.source = id;
+				e.sequence = i;
+				queue.push(e);
+			}
+		}));
+	}
+
+	// the consumer drains in batches and checks every producer's order.
+	vector<int> next(producers, 0);
+	bool ordered = true;
+	long received = 0;
+	long batches = 0;
+	while (received < long(producers) * perProducer) {
+		size_t const count = queue.pop_all([&next, &ordered](message& e) {
+			ordered = ordered && e.sequence == next[e.source];
+			next[e.source] = e.sequence + 1;
+		});
+		if (count == 0) {
+			this_thread::yield();
+			continue;
+		}
+		received += count;
+		++batches;
+	}
+	for (auto& thd : threads) {
+		thd.join();
+	}
+	cout << "received " << received << " messages in " << batches << " batches, in order per producer: "
+		<< boolalpha << ordered << ", empty: " << queue.empty() << endl;
+	return 0;
+}
@@ -0,0 +1,150 @@
+#ifndef INTRUSIVE_MPSC_QUEUE
+#define INTRUSIVE_MPSC_QUEUE
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include "../ch5/latch.h" // for spin_pause
+
+using namespace std;
+
+// derive the queued type from this; the queue links objects through it.
+struct mpsc_node {
+	atomic<mpsc_node*> next{nullptr};
+};
+
+/**
+ * Dmitry Vyukov's intrusive multi-producer single-consumer queue.
+ * push() is wait-free: one exchange on the head and a store into the previous
+ * node, no allocation and no lock, because the link lives in the pushed object.
+ * Only one thread may pop.
+ *
+ * A producer that has done its exchange but not yet its store briefly hides
+ * everything pushed after it, so pop() can come back empty while the queue
+ * is not; the items show up on a later pop.
+ *
+ * The queue doesn't own the objects: an object must stay alive until it is
+ * popped, and must not be pushed again before that.
+ */
+template <typename T>
+class intrusive_mpsc_queue {
+private:
+	// producers and the consumer work on different cache lines.
+	alignas(64) atomic<mpsc_node*> m_head;
+	alignas(64) mpsc_node* m_tail;
+	mpsc_node m_stub;
+	// consumer only: the stub is m_tail or linked somewhere behind it.
+	bool m_stubLinked = true;
+
+	void pushNode(mpsc_node* node) {
+		node->next.store(nullptr, memory_order_relaxed);
+		mpsc_node* const previous = m_head.exchange(node, memory_order_acq_rel);
+		previous->next.store(node, memory_order_release);
+	}
+
+	// for a node some later push has exchanged past: its link is at most in flight.
+	static mpsc_node* waitNext(mpsc_node* node) {
+		unsigned spins = 0;
+		mpsc_node* next;
+		while (!(next = node->next.load(memory_order_acquire))) {
+			if (++spins < 64) {
+				spin_pause();
+			} else {
+				this_thread::yield();
+			}
+		}
+		return next;
+	}
+
+public:
+	intrusive_mpsc_queue() : m_head(&m_stub), m_tail(&m_stub) {}
+	intrusive_mpsc_queue(intrusive_mpsc_queue const&) = delete;
+	intrusive_mpsc_queue& operator=(intrusive_mpsc_queue const&) = delete;
+
+	void push(T& item) {
+		pushNode(&item);
+	}
+
+	// consumer only; nullptr if nothing is ready.
+	T* pop() {
+		mpsc_node* tail = m_tail;
+		mpsc_node* next = tail->next.load(memory_order_acquire);
+		if (tail == &m_stub) {
+			if (!next) {
+				return nullptr;
+			}
+			m_tail = next;
+			m_stubLinked = false;
+			tail = next;
+			next = next->next.load(memory_order_acquire);
+		}
+		if (next) {
+			m_tail = next;
+			return static_cast<T*>(tail);
+		}
+		if (tail != m_head.load(memory_order_acquire)) {
+			// a push is half way through.
+			return nullptr;
+		}
+		// tail is the last node; put the stub behind it so it can be unlinked.
+		pushNode(&m_stub);
+		m_stubLinked = true;
+		next = tail->next.load(memory_order_acquire);
+		if (next) {
+			m_tail = next;
+			return static_cast<T*>(tail);
+		}
+		return nullptr;
+	}
+
+	/**
+	 * Consumer only: detaches everything pushed so far with one exchange on
+	 * the head, then hands the items to func in push order (per producer)
+	 * and returns how many there were. Unlike pop(), it waits for a producer
+	 * that has done its exchange but not yet its link.
+	 * func may push the item again, it is already unlinked; it must not
+	 * throw, or the rest of the batch is lost.
+	 */
+	template <typename Function>
+	size_t pop_all(Function func) {
+		size_t count = 0;
+		mpsc_node* first = m_tail;
+		if (first != &m_stub && m_stubLinked) {
+			// pop() put the stub behind a racing push; the items before it come first.
+			while (first != &m_stub) {
+				mpsc_node* const next = waitNext(first);
+				func(*static_cast<T*>(first));
+				++count;
+				first = next;
+			}
+			m_tail = &m_stub;
+		}
+		if (first == &m_stub) {
+			first = m_stub.next.load(memory_order_acquire);
+			if (!first) {
+				return count;
+			}
+		}
+		// the stub is out of the chain now, so it can end the next one.
+		m_stub.next.store(nullptr, memory_order_relaxed);
+		mpsc_node* const last = m_head.exchange(&m_stub, memory_order_acq_rel);
+		m_tail = &m_stub;
+		m_stubLinked = true;
+		for (mpsc_node* node = first;;) {
+			mpsc_node* const next = node != last ? waitNext(node) : nullptr;
+			func(*static_cast<T*>(node));
+			++count;
+			if (!next) {
+				return count;
+			}
+			node = next;
+		}
+	}
+
+	// consumer only, and only a hint while producers are active.
+	bool empty() const {
+		return m_tail == &m_stub && !m_stub.next.load(memory_order_acquire);
+	}
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "lock_free_skiplist.h"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main() {
+	// time-indexed events: every thread owns the timestamps t with t % 4 == id.
+	lock_free_skiplist<long, string> events;
+	int const perThread = 20000;
+	vector<thread> threads;
+	for (int id = 0; id < 4; ++id) {
+		threads.push_back(thread([&events, id]() {
+			for (int i = 0; i < perThread; ++i) {
+				long const t = long(i) * 4 + id;
+				events.insert(t, "event " + to_string(t));
+				// drop every third of the previous ones again.
+				if (i % 3 == 0 && i > 0) {
+					events.erase(long(i - 1) * 4 + id);
+				}
+			}
+		}));
+	}
+	// a reader scanning ranges while the writers are busy.
+	threads.push_back(thread([&events]() {
+		long seen = 0;
+		for (int round = 0; round < 200; ++round) {
+			events.for_range(1000, 2000, [&seen](pair<long const, string> const&) {
+				++seen;
+			});
+		}
+		cout << "reader saw " << seen << " entries in its scans" << endl;
+	}));
+	for (auto& thd : threads) {
+		thd.join();
+	}
+
+	long expected = 0;
+	for (int i = 0; i < perThread; ++i) {
+		if (!(i + 1 < perThread && (i + 1) % 3 == 0)) {
+			++expected;
+		}
+	}
+	expected *= 4;
+	long counted = 0;
+	long previous = -1;
+	bool ordered = true;
+	for (auto const& entry : events) {
+		ordered = ordered && entry.first > previous;
+		previous = entry.first;
+		++counted;
+	}
+	cout << "size " << events.size() << ", counted " << counted << ", expected " << expected
+		<< ", ordered: " << boolalpha << ordered << endl;
+
+	auto it = events.lower_bound(1001);
+	cout << "first event at or after 1001: " << it->first << " -> " << it->second << endl;
+	cout << "find 12: " << events.find(12).value_or("none") << ", find 8: " << events.find(8).value_or("none") << endl;
+	return 0;
+}
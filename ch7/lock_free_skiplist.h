@@ -0,0 +1,392 @@
+#ifndef LOCK_FREE_SKIPLIST
+#define LOCK_FREE_SKIPLIST
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "epoch_reclaimer.h"
+
+using namespace std;
+
+/**
+ * Ordered map after Herlihy and Shavit's lock-free skip list.
+ * A node is logically erased by setting the low bit of its next pointers,
+ * top level down; whoever marks level 0 owns the erase. Searches snip
+ * marked nodes out as they pass, and unlinked nodes go to the epoch reclaimer.
+ *
+ * Each node is one allocation: the key/value pair, then its tower of next
+ * pointers right behind it. The node reaches its tower through a pointer, so
+ * a search that visits a node reads that line and, unless the pair is small
+ * enough to share it, the tower's line next to it.
+ * The head is only a full-height tower, it carries no key or value.
+ * Towers grow with probability 1/4 per level, keeping the average at 1.33 pointers.
+ *
+ * Values are immutable once inserted; erase and insert again to change one.
+ */
+template <typename Key, typename Value, typename Compare = less<Key>>
+class lock_free_skiplist {
+public:
+	typedef pair<Key const, Value> value_type;
+
+private:
+	static unsigned const max_height = 16;
+
+	// what the head and the nodes have in common: a tower of next pointers.
+	struct tower {
+		atomic<uintptr_t>* const next;
+		unsigned const height;
+
+		tower(atomic<uintptr_t>* next_, unsigned height_) : next(next_), height(height_) {}
+	};
+
+	// next points just past the node, into the same allocation.
+	struct node : tower {
+		// the inserting thread and the erasing one both have to be done with it.
+		atomic<unsigned> owners{2};
+		value_type value;
+
+		template <typename... Args>
+		node(atomic<uintptr_t>* next_, unsigned height_, Args&&... args) :
+			tower(next_, height_), value(forward<Args>(args)...) {}
+	};
+
+	struct head_tower : tower {
+		atomic<uintptr_t> links[max_height];
+
+		head_tower() : tower(links, max_height) {
+			for (auto& link : links) {
+				link.store(0, memory_order_relaxed);
+			}
+		}
+	};
+
+	head_tower head;
+	Compare comp;
+	atomic<long> count{0};
+
+	// sizeof(node) is a multiple of its alignment, which covers the tower's.
+	template <typename... Args>
+	static node* create_node(unsigned height, Args&&... args) {
+		char* memory = static_cast<char*>(::operator new(sizeof(node) + height * sizeof(atomic<uintptr_t>)));
+		atomic<uintptr_t>* next = reinterpret_cast<atomic<uintptr_t>*>(memory + sizeof(node));
+		for (unsigned level = 0; level < height; ++level) {
+			new (next + level) atomic<uintptr_t>(0);
+		}
+		try {
+			return new (memory) node(next, height, forward<Args>(args)...);
+		} catch (...) {
+			::operator delete(memory);
+			throw;
+		}
+	}
+
+	static void destroy_node(void* p) {
+		node* n = static_cast<node*>(p);
+		n->~node();
+		::operator delete(n);
+	}
+
+	static node* pointer(uintptr_t link) {
+		return reinterpret_cast<node*>(link & ~uintptr_t(1));
+	}
+
+	static bool marked(uintptr_t link) {
+		return link & 1;
+	}
+
+	static uintptr_t link_to(node* n) {
+		return reinterpret_cast<uintptr_t>(n);
+	}
+
+	static unsigned random_height() {
+		static thread_local unsigned long long state =
+			0x9E3779B97F4A7C15ull ^ hash<thread::id>()(this_thread::get_id());
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		unsigned height = 1;
+		for (unsigned long long bits = state; height < max_height && (bits & 3) == 0; bits >>= 2) {
+			++height;
+		}
+		return height;
+	}
+
+	bool less_than(node* n, Key const& key) const {
+		return comp(n->value.first, key);
+	}
+
+	bool equal(node* n, Key const& key) const {
+		return n && !comp(n->value.first, key) && !comp(key, n->value.first);
+	}
+
+	void release(node* n) {
+		if (n->owners.fetch_sub(1, memory_order_acq_rel) == 1) {
+			epoch_reclaimer::instance().retire(n, &destroy_node);
+		}
+	}
+
+	/**
+	 * Fills the last node before key and the first one at or after it on
+	 * every level, unlinking marked nodes on the way. Must run in an epoch_guard.
+	 */
+	bool find(Key const& key, tower** preds, node** succs) {
+	retry:
+		tower* pred = &head;
+		for (int level = max_height - 1; level >= 0; --level) {
+			node* curr = pointer(pred->next[level].load(memory_order_acquire));
+			while (curr) {
+				uintptr_t succ = curr->next[level].load(memory_order_acquire);
+				while (marked(succ)) {
+					uintptr_t expected = link_to(curr);
+					if (!pred->next[level].compare_exchange_strong(expected, succ & ~uintptr_t(1),
+							memory_order_acq_rel, memory_order_acquire)) {
+						goto retry;
+					}
+					curr = pointer(succ);
+					if (!curr) {
+						break;
+					}
+					succ = curr->next[level].load(memory_order_acquire);
+				}
+				if (curr && less_than(curr, key)) {
+					pred = curr;
+					curr = pointer(succ);
+				} else {
+					break;
+				}
+			}
+			preds[level] = pred;
+			succs[level] = curr;
+		}
+		return equal(succs[0], key);
+	}
+
+	// first unmarked node at or after key, without unlinking anything.
+	node* search(Key const& key) const {
+		tower const* pred = &head;
+		node* curr = nullptr;
+		for (int level = max_height - 1; level >= 0; --level) {
+			curr = pointer(pred->next[level].load(memory_order_acquire));
+			while (curr) {
+				uintptr_t const succ = curr->next[level].load(memory_order_acquire);
+				if (marked(succ)) {
+					curr = pointer(succ);
+				} else if (less_than(curr, key)) {
+					pred = curr;
+					curr = pointer(succ);
+				} else {
+					break;
+				}
+			}
+		}
+		return curr;
+	}
+
+	static node* next_live(node* n) {
+		while (n && marked(n->next[0].load(memory_order_acquire))) {
+			n = pointer(n->next[0].load(memory_order_acquire));
+		}
+		return n;
+	}
+
+public:
+	/**
+	 * Forward iterator over the live entries, in key order.
+	 * It holds an epoch guard, so the entry it points at stays valid even if
+	 * erased meanwhile; it must not be handed to another thread. end() and
+	 * default-constructed iterators hold none, so comparing against end() is cheap.
+	 * Concurrent inserts and erases ahead of it may or may not be seen.
+	 */
+	class iterator {
+	private:
+		friend class lock_free_skiplist;
+		optional<epoch_guard> guard;
+		node* current = nullptr;
+
+		explicit iterator(node* n) : guard(in_place), current(next_live(n)) {}
+
+	public:
+		typedef forward_iterator_tag iterator_category;
+		typedef typename lock_free_skiplist::value_type value_type;
+		typedef ptrdiff_t difference_type;
+		typedef value_type const* pointer;
+		typedef value_type const& reference;
+
+		iterator() {}
+
+		reference operator*() const {
+			return current->value;
+		}
+		pointer operator->() const {
+			return &current->value;
+		}
+		iterator& operator++() {
+			current = next_live(lock_free_skiplist::pointer(current->next[0].load(memory_order_acquire)));
+			return *this;
+		}
+		iterator operator++(int) {
+			iterator old(*this);
+			++*this;
+			return old;
+		}
+		bool operator==(iterator const& other) const {
+			return current == other.current;
+		}
+		bool operator!=(iterator const& other) const {
+			return current != other.current;
+		}
+	};
+
+	explicit lock_free_skiplist(Compare comp_ = Compare()) : comp(comp_) {}
+	lock_free_skiplist(lock_free_skiplist const&) = delete;
+	lock_free_skiplist& operator=(lock_free_skiplist const&) = delete;
+
+	// no other thread may be using the map any more.
+	~lock_free_skiplist() {
+		node* n = pointer(head.next[0].load(memory_order_relaxed));
+		while (n) {
+			node* next = pointer(n->next[0].load(memory_order_relaxed));
+			destroy_node(n);
+			n = next;
+		}
+	}
+
+	// false if the key is already there.
+	template <typename K, typename V>
+	bool insert(K&& key, V&& value) {
+		epoch_guard guard;
+		tower* preds[max_height];
+		node* succs[max_height];
+		unsigned const height = random_height();
+		node* n = nullptr;
+		while (true) {
+			Key const& search_key = n ? n->value.first : key;
+			if (find(search_key, preds, succs)) {
+				if (n) {
+					destroy_node(n);
+				}
+				return false;
+			}
+			if (!n) {
+				n = create_node(height, piecewise_construct, forward_as_tuple(forward<K>(key)),
+					forward_as_tuple(forward<V>(value)));
+			}
+			for (unsigned level = 0; level < height; ++level) {
+				n->next[level].store(link_to(succs[level]), memory_order_relaxed);
+			}
+			uintptr_t expected = link_to(succs[0]);
+			if (preds[0]->next[0].compare_exchange_strong(expected, link_to(n),
+					memory_order_release, memory_order_relaxed)) {
+				break;
+			}
+		}
+		++count;
+
+		// the upper levels are only shortcuts; an erase may cut them short.
+		Key const& key_ref = n->value.first;
+		for (unsigned level = 1; level < height; ++level) {
+			while (true) {
+				uintptr_t link = n->next[level].load(memory_order_acquire);
+				if (marked(link)) {
+					release(n);
+					return true;
+				}
+				if (pointer(link) != succs[level] &&
+					!n->next[level].compare_exchange_strong(link, link_to(succs[level]), memory_order_acq_rel)) {
+					continue;
+				}
+				uintptr_t expected = link_to(succs[level]);
+				if (preds[level]->next[level].compare_exchange_strong(expected, link_to(n),
+						memory_order_release, memory_order_relaxed)) {
+					break;
+				}
+				find(key_ref, preds, succs);
+				if (succs[0] != n) {
+					release(n);
+					return true;
+				}
+			}
+			// erased while this level was being linked: make sure it is unlinked again.
+			if (marked(n->next[level].load(memory_order_acquire))) {
+				find(key_ref, preds, succs);
+				break;
+			}
+		}
+		release(n);
+		return true;
+	}
+
+	bool erase(Key const& key) {
+		epoch_guard guard;
+		tower* preds[max_height];
+		node* succs[max_height];
+		if (!find(key, preds, succs)) {
+			return false;
+		}
+		node* victim = succs[0];
+		for (unsigned level = victim->height - 1; level >= 1; --level) {
+			uintptr_t link = victim->next[level].load(memory_order_acquire);
+			while (!marked(link) && !victim->next[level].compare_exchange_weak(link, link | 1, memory_order_acq_rel));
+		}
+		uintptr_t link = victim->next[0].load(memory_order_acquire);
+		while (true) {
+			if (marked(link)) {
+				return false;
+			}
+			if (victim->next[0].compare_exchange_strong(link, link | 1, memory_order_acq_rel)) {
+				--count;
+				find(key, preds, succs);
+				release(victim);
+				return true;
+			}
+		}
+	}
+
+	optional<Value> find(Key const& key) const {
+		epoch_guard guard;
+		node* n = search(key);
+		if (equal(n, key)) {
+			return n->value.second;
+		}
+		return nullopt;
+	}
+
+	bool contains(Key const& key) const {
+		epoch_guard guard;
+		return equal(search(key), key);
+	}
+
+	iterator lower_bound(Key const& key) const {
+		epoch_guard guard;
+		return iterator(search(key));
+	}
+
+	iterator begin() const {
+		epoch_guard guard;
+		return iterator(pointer(head.next[0].load(memory_order_acquire)));
+	}
+
+	iterator end() const {
+		return iterator();
+	}
+
+	// calls func(entry) for every entry with first <= key < last.
+	template <typename Function>
+	void for_range(Key const& first, Key const& last, Function func) const {
+		for (iterator it = lower_bound(first); it != end() && comp(it->first, last); ++it) {
+			func(*it);
+		}
+	}
+
+	// exact when quiescent.
+	long size() const {
+		return count.load(memory_order_relaxed);
+	}
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef NODE_POOL
+#define NODE_POOL
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+using namespace std;
+
+/**
+ * Fixed-size blocks recycled through a per-thread cache.
+ * A thread that runs dry takes the whole global free list with one exchange,
+ * and a thread whose cache grows too large hands half of it back,
+ * so blocks freed on another thread find their way to the producers again.
+ * Only whole-list exchange ever removes from the global list, so there is no ABA.
+ * Blocks freed while the thread's cache is being torn down, or after it,
+ * go straight to the global list.
+ */
+template <size_t block_size>
+class node_pool {
+private:
+	struct free_block {
+		free_block* next;
+	};
+
+	static size_t const max_cached = 256;
+	static size_t const slab_blocks = 64;
+
+	struct thread_cache {
+		free_block* head = nullptr;
+		size_t count = 0;
+
+		~thread_cache() {
+			cache_destroyed() = true;
+			if (head) {
+				give_back(head, count);
+			}
+			head = nullptr;
+			count = 0;
+		}
+	};
+
+	static atomic<free_block*> global_list;
+
+	static thread_cache& local() {
+		static thread_local thread_cache cache;
+		return cache;
+	}
+
+	// trivially destructible, so it can still be read once the cache is gone.
+	static bool& cache_destroyed() {
+		static thread_local bool destroyed = false;
+		return destroyed;
+	}
+
+	static void give_back(free_block* first, size_t count) {
+		free_block* last = first;
+		for (size_t i = 1; i < count; ++i) {
+			last = last->next;
+		}
+		last->next = global_list.load(memory_order_relaxed);
+		while (!global_list.compare_exchange_weak(last->next, first,
+				memory_order_release, memory_order_relaxed));
+	}
+
+	static void refill(thread_cache& cache) {
+		free_block* taken = global_list.exchange(nullptr, memory_order_acquire);
+		if (taken) {
+			cache.head = taken;
+			for (; taken; taken = taken->next) {
+				++cache.count;
+			}
+			return;
+		}
+		char* slab = static_cast<char*>(::operator new(block_size * slab_blocks));
+		for (size_t i = 0; i < slab_blocks; ++i) {
+			free_block* block = reinterpret_cast<free_block*>(slab + i * block_size);
+			block->next = cache.head;
+			cache.head = block;
+		}
+		cache.count += slab_blocks;
+	}
+
+public:
+	static_assert(block_size >= sizeof(free_block), "block too small for the free list link");
+	static_assert(block_size % alignof(max_align_t) == 0, "block size must keep blocks aligned");
+
+	static void* allocate() {
+		if (cache_destroyed()) {
+			// the block may later join the free lists like any other.
+			return ::operator new(block_size);
+		}
+		thread_cache& cache = local();
+		if (!cache.head) {
+			refill(cache);
+		}
+		free_block* block = cache.head;
+		cache.head = block->next;
+		--cache.count;
+		return block;
+	}
+
+	static void deallocate(void* p) noexcept {
+		free_block* block = static_cast<free_block*>(p);
+		if (cache_destroyed()) {
+			give_back(block, 1);
+			return;
+		}
+		thread_cache& cache = local();
+		block->next = cache.head;
+		cache.head = block;
+		if (++cache.count > max_cached) {
+			size_t const keep = max_cached / 2;
+			free_block* split = cache.head;
+			for (size_t i = 1; i < keep; ++i) {
+				split = split->next;
+			}
+			free_block* surplus = split->next;
+			split->next = nullptr;
+			give_back(surplus, cache.count - keep);
+			cache.count = keep;
+		}
+	}
+};
+
+template <size_t block_size>
+atomic<typename node_pool<block_size>::free_block*> node_pool<block_size>::global_list{nullptr};
+
+/**
+ * Standard allocator front end: single objects come from the pool of their
+ * size class, arrays and over-aligned types go to the normal heap.
+ */
+template <typename T>
+class pool_allocator {
+private:
+	static constexpr size_t size_class() {
+		return (sizeof(T) + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t);
+	}
+
+	static constexpr bool pooled(size_t n) {
+		return n == 1 && alignof(T) <= alignof(max_align_t);
+	}
+
+public:
+	typedef T value_type;
+
+	pool_allocator() noexcept {}
+	template <typename U>
+	pool_allocator(pool_allocator<U> const&) noexcept {}
+
+	T* allocate(size_t n) {
+		if (!pooled(n)) {
+			return allocator<T>().allocate(n);
+		}
+		return static_cast<T*>(node_pool<size_class()>::allocate());
+	}
+
+	void deallocate(T* p, size_t n) noexcept {
+		if (!pooled(n)) {
+			allocator<T>().deallocate(p, n);
+			return;
+		}
+		node_pool<size_class()>::deallocate(p);
+	}
+};
+
+template <typename T, typename U>
+bool operator==(pool_allocator<T> const&, pool_allocator<U> const&) {
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(pool_allocator<T> const&, pool_allocator<U> const&) {
+	return false;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef COMBINABLE
+#define COMBINABLE
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "per_thread_slots.h"
+
+using namespace std;
+
+/**
+ * One T per thread, folded together when the work is done.
+ * local() hands the calling thread its own slot, created on first use,
+ * so threads add into private cache lines instead of a shared total.
+ * Slots outlive their threads and are combined like the others.
+ *
+ * local() may be called concurrently; combine(), combine_each() and clear()
+ * expect the threads that use local() to be finished.
+ */
+template <typename T>
+class combinable {
+private:
+	struct alignas(64) slot {
+		T value;
+		thread::id owner;
+		slot* next = nullptr;
+
+		template <typename... Args>
+		explicit slot(thread::id owner_, Args&&... args) : value(forward<Args>(args)...), owner(owner_) {}
+	};
+
+	function<T()> m_init;
+	per_thread_slots<slot> m_slots;
+
+	slot* makeSlot() {
+		if constexpr (is_move_constructible<T>::value) {
+			if (m_init) {
+				return new slot(this_thread::get_id(), m_init());
+			}
+		}
+		return new slot(this_thread::get_id());
+	}
+
+public:
+	combinable() = default;
+	explicit combinable(function<T()> init) : m_init(move(init)) {}
+	combinable(combinable const&) = delete;
+	combinable& operator=(combinable const&) = delete;
+
+	T& local() {
+		return m_slots.local([this]() {
+			return makeSlot();
+		}).value;
+	}
+
+	template <typename Function>
+	void combine_each(Function func) const {
+		for (slot* s = m_slots.head(); s; s = s->next) {
+			func(s->value);
+		}
+	}
+
+	// op must be associative and commutative, slots come in no particular order.
+	template <typename BinaryOp>
+	T combine(BinaryOp op) const {
+		slot* s = m_slots.head();
+		if (!s) {
+			return m_init ? m_init() : T();
+		}
+		T result = s->value;
+		for (s = s->next; s; s = s->next) {
+			result = op(move(result), s->value);
+		}
+		return result;
+	}
+
+	void clear() {
+		m_slots.clear();
+	}
+};
+
+/**
+ * A counter bumped from many threads, each into its own padded slot.
+ * Unlike combinable, read() may run while others are adding;
+ * it sees every add that happened before it, and maybe some concurrent ones.
+ */
+class sharded_counter {
+private:
+	combinable<atomic<long long>> m_slots;
+
+public:
+	void add(long long n = 1) {
+		atomic<long long>& local = m_slots.local();
+		// only this thread writes the slot, so no read-modify-write is needed.
+		local.store(local.load(memory_order_relaxed) + n, memory_order_relaxed);
+	}
+
+	long long read() const {
+		long long sum = 0;
+		m_slots.combine_each([&sum](atomic<long long> const& value) {
+			sum += value.load(memory_order_relaxed);
+		});
+		return sum;
+	}
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "deterministic_reduce.h"
+#include "parallel_accumulate.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+template <typename Function>
+double timeMs(Function func) {
+	auto start = chrono::steady_clock::now();
+	func();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	// values of very different magnitudes, so the summation order shows in the result.
+	vector<double> values(10000000);
+	mt19937_64 rng(3);
+	uniform_real_distribution<double> mantissa(-1.0, 1.0);
+	for (auto& v : values) {
+		v = mantissa(rng) * pow(10.0, int(rng() % 12));
+	}
+
+	cout << setprecision(17);
+	for (summation mode : {summation::pairwise, summation::kahan}) {
+		double const reference = deterministic_sum(values.begin(), values.end(), 0.0, mode, 1);
+		bool identical = true;
+		for (unsigned threads : {2u, 3u, 7u, 16u, 64u}) {
+			double const sum = parallel_accumulate(values.begin(), values.end(), 0.0, mode, threads);
+			identical = identical && memcmp(&sum, &reference, sizeof(double)) == 0;
+		}
+		cout << (mode == summation::kahan ? "kahan:    " : "pairwise: ") << reference
+			<< ", bit-identical for 1..64 threads: " << boolalpha << identical << endl;
+	}
+
+	cout << "plain parallel_accumulate:";
+	for (unsigned threads : {1u, 3u, 7u}) {
+		cout << " " << parallel_accumulate(values.begin(), values.end(), 0.0, threads);
+	}
+	cout << endl;
+
+	cout << setprecision(6);
+	double sink = 0;
+	double const plainMs = timeMs([&]() { sink += parallel_accumulate(values.begin(), values.end(), 0.0); });
+	double const pairwiseMs = timeMs([&]() { sink += deterministic_sum(values.begin(), values.end(), 0.0); });
+	double const kahanMs = timeMs([&]() { sink += deterministic_sum(values.begin(), values.end(), 0.0, summation::kahan); });
+	cout << "plain " << plainMs << " ms, pairwise " << pairwiseMs << " ms, kahan " << kahanMs << " ms" << endl;
+
+	vector<int> ints(100000, 3);
+	cout << "deterministic_reduce max: " << deterministic_reduce(ints.begin(), ints.end(), 0, [](int a, int b) {
+		return max(a, b);
+	}) << endl;
+	return sink == 0.123 ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+#ifndef DETERMINISTIC_REDUCE
+#define DETERMINISTIC_REDUCE
+
+#include <array>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include "parallel_engine.h"
+
+using namespace std;
+
+/**
+ * Reductions whose result does not depend on the thread count.
+ * The input is cut into blocks of a fixed size, every block is reduced
+ * on its own, and the block results are combined in a fixed binary tree
+ * over the block indices. Threads only decide who computes which block,
+ * so the same input gives bit-identical results on any machine
+ * (as long as the compiler doesn't reassociate, i.e. no -ffast-math).
+ */
+inline constexpr unsigned long deterministic_block_size = 4096;
+
+// values[first, last) combined by halves, always the same tree for the same count.
+template <typename Container, typename BinaryOp>
+typename Container::value_type reduce_tree(Container& values, size_t first, size_t last, BinaryOp& op) {
+	if (last - first == 1) {
+		return values[first];
+	}
+	size_t const middle = first + (last - first) / 2;
+	typename Container::value_type left = reduce_tree(values, first, middle, op);
+	return op(move(left), reduce_tree(values, middle, last, op));
+}
+
+// a sum with the rounding error it has lost so far: the exact value is about sum + error.
+template <typename T>
+struct compensated_sum {
+	T sum;
+	T error;
+};
+
+template <typename T>
+compensated_sum<T> add_exact(compensated_sum<T> const& a, compensated_sum<T> const& b) {
+	// Knuth's two-sum, the rounding error of a.sum + b.sum.
+	T const sum = a.sum + b.sum;
+	T const b_part = sum - a.sum;
+	T const rounding = (a.sum - (sum - b_part)) + (b.sum - b_part);
+	return compensated_sum<T>{sum, a.error + b.error + rounding};
+}
+
+/**
+ * op must be associative, up to rounding; init is applied last.
+ * Each block is folded left to right.
+ */
+template <typename Iterator, typename T, typename BinaryOp>
+T deterministic_reduce(Iterator first, Iterator last, T init, BinaryOp op,
+		unsigned long hardware_threads = thread::hardware_concurrency(),
+		unsigned long block_size = deterministic_block_size) {
+	unsigned long const length = distance(first, last);
+	if (length == 0) {
+		return init;
+	}
+	unsigned long const blocks = (length + block_size - 1) / block_size;
+	vector<T> results(blocks, init);
+	parallel_blocks(0ul, blocks, block_partition(blocks, hardware_threads, 1),
+		[&](unsigned long, unsigned long block_first, unsigned long block_last) {
+			for (unsigned long block = block_first; block < block_last; ++block) {
+				Iterator it = first;
+				advance(it, block * block_size);
+				unsigned long const n = min(block_size, length - block * block_size);
+				T partial = *it;
+				for (unsigned long i = 1; i < n; ++i) {
+					partial = op(move(partial), *++it);
+				}
+				results[block] = move(partial);
+			}
+		});
+	return op(move(init), reduce_tree(results, 0, blocks, op));
+}
+
+enum class summation {
+	// plain sums in each block, combined pairwise.
+	pairwise,
+	// Kahan compensated sums in each block, combined with the exact rounding error.
+	kahan
+};
+
+/**
+ * Floating-point sum of a random-access range, reproducible across thread counts.
+ * Each block is summed in 8 interleaved lanes, which keeps the adds
+ * independent so the compiler can vectorize them; the lanes are then
+ * added pairwise, in the same fixed order every time.
+ */
+template <typename Iterator, typename T>
+T deterministic_sum(Iterator first, Iterator last, T init, summation mode = summation::pairwise,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	typedef compensated_sum<T> partial_sum;
+	static unsigned const lanes = 8;
+	unsigned long const length = last - first;
+	if (length == 0) {
+		return init;
+	}
+	unsigned long const blocks = (length + deterministic_block_size - 1) / deterministic_block_size;
+	auto combine = [mode](partial_sum a, partial_sum const& b) {
+		return mode == summation::kahan ? add_exact(a, b) : partial_sum{a.sum + b.sum, T()};
+	};
+	vector<partial_sum> results(blocks);
+	parallel_blocks(0ul, blocks, block_partition(blocks, hardware_threads, 1),
+		[&](unsigned long, unsigned long block_first, unsigned long block_last) {
+			for (unsigned long block = block_first; block < block_last; ++block) {
+				Iterator const data = first + block * deterministic_block_size;
+				unsigned long const n = min(deterministic_block_size, length - block * deterministic_block_size);
+				T sum[lanes] = {};
+				T error[lanes] = {};
+				unsigned long i = 0;
+				if (mode == summation::pairwise) {
+					for (; i + lanes <= n; i += lanes) {
+						for (unsigned k = 0; k < lanes; ++k) {
+							sum[k] += T(data[i + k]);
+						}
+					}
+					for (; i < n; ++i) {
+						sum[i % lanes] += T(data[i]);
+					}
+				} else {
+					auto kahan_add = [&](unsigned k, T value) {
+						T const y = value - error[k];
+						T const t = sum[k] + y;
+						error[k] = (t - sum[k]) - y;
+						sum[k] = t;
+					};
+					for (; i + lanes <= n; i += lanes) {
+						for (unsigned k = 0; k < lanes; ++k) {
+							kahan_add(k, T(data[i + k]));
+						}
+					}
+					for (; i < n; ++i) {
+						kahan_add(i % lanes, T(data[i]));
+					}
+				}
+				// Kahan's correction is subtracted, the compensated error is added.
+				array<partial_sum, lanes> lane_sums;
+				for (unsigned k = 0; k < lanes; ++k) {
+					lane_sums[k] = partial_sum{sum[k], -error[k]};
+				}
+				results[block] = reduce_tree(lane_sums, 0, lanes, combine);
+			}
+		});
+	partial_sum const total = reduce_tree(results, 0, blocks, combine);
+	return init + (total.sum + total.error);
+}
+
+#endif
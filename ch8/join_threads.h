@@ -0,0 +1,67 @@
+#ifndef JOIN_THREADS
+#define JOIN_THREADS
+
+#include <thread>
+#include <vector>
+#include "topology.h"
+#include "trace.h"
+
+using namespace std;
+
+/**
+ * For exceptional safety.
+ */
+class join_threads {
+private:
+	std::vector<thread>& m_threads;
+	vector<int> const& m_cpus;
+	// the calling thread's own affinity while place_caller() has it pinned.
+	cpu_set_t m_callerCpus;
+	bool m_callerPinned = false;
+public:
+	join_threads(std::vector<thread>& t_thread, placement policy = thread_placement()) :
+		m_threads(t_thread), m_cpus(placement_order(policy)) {}
+
+	/**
+	 * Pins the calling thread to the first CPU under the placement policy,
+	 * for callers that work on a block too. Its affinity is restored once
+	 * the threads are joined, so the destructor must run on the same thread.
+	 */
+	void place_caller() {
+		if (m_cpus.empty() || m_callerPinned) {
+			return;
+		}
+		pthread_t const self = pthread_self();
+		if (pthread_getaffinity_np(self, sizeof(m_callerCpus), &m_callerCpus) == 0) {
+			m_callerPinned = pin_thread(self, m_cpus[0]);
+		}
+	}
+
+	/**
+	 * Pins thread index to its CPU under the placement policy.
+	 * The first CPU is left to the calling thread, see place_caller().
+	 */
+	void place(size_t index) {
+		if (!m_cpus.empty() && m_threads[index].joinable()) {
+			pin_thread(m_threads[index], m_cpus[(index + 1) % m_cpus.size()]);
+		}
+	}
+
+	/**
+	 * If throwing exception before the threads are joined,
+	 * it will automatically join to avoid threads become dangling.
+	 */
+	~join_threads() {
+		TRACE_SCOPE("join_threads");
+		for (thread& thd : m_threads) {
+			if (thd.joinable()) {
+				thd.join();
+			}
+		}
+		if (m_callerPinned) {
+			pthread_setaffinity_np(pthread_self(), sizeof(m_callerCpus), &m_callerCpus);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "light_future.h"
+
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// runs posted work on a thread of its own, one task at a time.
+struct thread_executor {
+	vector<thread> threads;
+	~thread_executor() {
+		for (auto& thd : threads) {
+			thd.join();
+		}
+	}
+	template <typename Function>
+	void post(Function func) {
+		threads.push_back(thread(move(func)));
+	}
+};
+
+int main() {
+	light_promise<int> promise;
+	light_future<string> text = promise.get_future()
+		.then([](int value) { return value * 2; })
+		.then([](int value) { return "doubled: " + to_string(value); });
+	thread producer([&]() {
+		promise.set_value(21);
+	});
+	cout << text.get() << endl;
+	producer.join();
+
+	// forked sums joined with when_all.
+	vector<int> data(100000, 1);
+	vector<light_promise<long>> parts(4);
+	vector<light_future<long>> futures;
+	vector<thread> workers;
+	size_t const block = data.size() / parts.size();
+	for (size_t i = 0; i < parts.size(); ++i) {
+		futures.push_back(parts[i].get_future());
+		workers.push_back(thread([&, i]() {
+			parts[i].set_value(accumulate(data.begin() + i * block, data.begin() + (i + 1) * block, 0L));
+		}));
+	}
+	thread_executor executor;
+	light_future<long> total = when_all(move(futures)).then(executor, [](vector<long> sums) {
+		return accumulate(sums.begin(), sums.end(), 0L);
+	});
+	cout << "total: " << total.get() << endl;
+	for (auto& thd : workers) {
+		thd.join();
+	}
+
+	// exceptions travel down the chain.
+	light_promise<int> failing;
+	light_future<int> chained = failing.get_future().then([](int value) { return value + 1; });
+	failing.set_exception(make_exception_ptr(runtime_error("no value")));
+	try {
+		chained.get();
+	} catch (exception const& e) {
+		cout << "caught: " << e.what() << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,362 @@
+#ifndef LIGHT_FUTURE
+#define LIGHT_FUTURE
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future> // for future_error
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Shared state of a light_promise / light_future pair.
+ * One allocation holding the value, the reference count and a state word,
+ * no mutex and no condition variable. Readiness is a single atomic load.
+ */
+template <typename T>
+class light_state {
+public:
+	typedef conditional_t<is_void<T>::value, monostate, T> stored_type;
+
+	enum : unsigned { empty = 0, has_continuation = 1, ready = 2 };
+
+	atomic<unsigned> state{empty};
+	// the promise's reference; get_future() adds the future's.
+	atomic<unsigned> refs{1};
+	// only touched by the promise side.
+	bool future_retrieved = false;
+	optional<stored_type> value;
+	exception_ptr error;
+	function<void()> continuation;
+
+	void release() {
+		if (refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+			delete this;
+		}
+	}
+
+	// the producer side is done writing value or error.
+	void publish() {
+		if (state.exchange(ready, memory_order_acq_rel) == has_continuation) {
+			function<void()> func = move(continuation);
+			func();
+		}
+#if defined(__cpp_lib_atomic_wait)
+		state.notify_all();
+#endif
+	}
+
+	bool is_ready() const {
+		return state.load(memory_order_acquire) == ready;
+	}
+
+	void wait() const {
+		for (int spin = 0; spin < 64; ++spin) {
+			if (is_ready()) {
+				return;
+			}
+		}
+		unsigned current;
+		while ((current = state.load(memory_order_acquire)) != ready) {
+#if defined(__cpp_lib_atomic_wait)
+			state.wait(current, memory_order_acquire);
+#else
+			this_thread::yield();
+#endif
+		}
+	}
+
+	// runs func once the state is ready, inline if it already is.
+	void on_ready(function<void()> func) {
+		continuation = move(func);
+		unsigned expected = empty;
+		if (!state.compare_exchange_strong(expected, has_continuation, memory_order_acq_rel)) {
+			function<void()> now = move(continuation);
+			now();
+		}
+	}
+};
+
+template <typename T>
+class light_future;
+
+template <typename T>
+class light_promise {
+private:
+	light_state<T>* m_state;
+
+	void check() const {
+		if (!m_state) {
+			throw future_error(future_errc::no_state);
+		}
+	}
+
+	// only the producer publishes, so its own relaxed load sees every earlier result.
+	void checkUnsatisfied() const {
+		check();
+		if (m_state->state.load(memory_order_relaxed) == light_state<T>::ready) {
+			throw future_error(future_errc::promise_already_satisfied);
+		}
+	}
+
+public:
+	light_promise() : m_state(new light_state<T>) {}
+	light_promise(light_promise&& other) noexcept : m_state(other.m_state) {
+		other.m_state = nullptr;
+	}
+	light_promise& operator=(light_promise&& other) noexcept {
+		if (this != &other) {
+			this->~light_promise();
+			m_state = other.m_state;
+			other.m_state = nullptr;
+		}
+		return *this;
+	}
+	light_promise(light_promise const&) = delete;
+	light_promise& operator=(light_promise const&) = delete;
+
+	~light_promise() {
+		if (!m_state) {
+			return;
+		}
+		if (m_state->state.load(memory_order_relaxed) != light_state<T>::ready) {
+			m_state->error = make_exception_ptr(future_error(future_errc::broken_promise));
+			m_state->publish();
+		}
+		m_state->release();
+	}
+
+	// only one future per promise, like std::promise.
+	light_future<T> get_future() {
+		check();
+		if (m_state->future_retrieved) {
+			throw future_error(future_errc::future_already_retrieved);
+		}
+		m_state->future_retrieved = true;
+		m_state->refs.fetch_add(1, memory_order_relaxed);
+		return light_future<T>(m_state);
+	}
+
+	template <typename... Args>
+	void set_value(Args&&... args) {
+		checkUnsatisfied();
+		m_state->value.emplace(forward<Args>(args)...);
+		m_state->publish();
+	}
+
+	void set_exception(exception_ptr error) {
+		checkUnsatisfied();
+		m_state->error = error;
+		m_state->publish();
+	}
+};
+
+template <typename T>
+class light_future {
+private:
+	light_state<T>* m_state;
+
+	template <typename U>
+	friend class light_promise;
+
+	explicit light_future(light_state<T>* state) : m_state(state) {}
+
+	light_state<T>* take() {
+		if (!m_state) {
+			throw future_error(future_errc::no_state);
+		}
+		light_state<T>* state = m_state;
+		m_state = nullptr;
+		return state;
+	}
+
+	/**
+	 * Feeds the result of func(value) into promise, exceptions included.
+	 */
+	template <typename Function, typename R>
+	static void run_continuation(light_state<T>* state, Function& func, light_promise<R>& promise) {
+		try {
+			if (state->error) {
+				rethrow_exception(state->error);
+			}
+			if constexpr (is_void<T>::value && is_void<R>::value) {
+				func();
+				promise.set_value();
+			} else if constexpr (is_void<T>::value) {
+				promise.set_value(func());
+			} else if constexpr (is_void<R>::value) {
+				func(move(*state->value));
+				promise.set_value();
+			} else {
+				promise.set_value(func(move(*state->value)));
+			}
+		} catch (...) {
+			promise.set_exception(current_exception());
+		}
+		state->release();
+	}
+
+public:
+	light_future() : m_state(nullptr) {}
+	light_future(light_future&& other) noexcept : m_state(other.m_state) {
+		other.m_state = nullptr;
+	}
+	light_future& operator=(light_future&& other) noexcept {
+		if (this != &other) {
+			this->~light_future();
+			m_state = other.m_state;
+			other.m_state = nullptr;
+		}
+		return *this;
+	}
+	light_future(light_future const&) = delete;
+	light_future& operator=(light_future const&) = delete;
+
+	~light_future() {
+		if (m_state) {
+			m_state->release();
+		}
+	}
+
+	bool valid() const {
+		return m_state != nullptr;
+	}
+
+	bool is_ready() const {
+		return m_state && m_state->is_ready();
+	}
+
+	void wait() const {
+		m_state->wait();
+	}
+
+	T get() {
+		light_state<T>* state = take();
+		state->wait();
+		unique_ptr<light_state<T>, void (*)(light_state<T>*)> guard(state, [](light_state<T>* s) {
+			s->release();
+		});
+		if (state->error) {
+			rethrow_exception(state->error);
+		}
+		if constexpr (!is_void<T>::value) {
+			return move(*state->value);
+		}
+	}
+
+	/**
+	 * func(ready_future) once the result is in; get() on it yields the value
+	 * or rethrows, so errors reach func too.
+	 */
+	template <typename Function>
+	void when_ready(Function func) {
+		light_state<T>* state = take();
+		state->on_ready([state, func = move(func)]() mutable {
+			func(light_future<T>(state));
+		});
+	}
+
+	/**
+	 * func(value) runs on whichever thread completes the promise,
+	 * or right away if the value is already there.
+	 */
+	template <typename Function>
+	auto then(Function func) {
+		typedef conditional_t<is_void<T>::value, invoke_result<Function>, invoke_result<Function, T>> result_of;
+		typedef typename result_of::type R;
+		light_state<T>* state = take();
+		light_promise<R> promise;
+		light_future<R> next = promise.get_future();
+		auto shared_promise = make_shared<light_promise<R>>(move(promise));
+		state->on_ready([state, func = move(func), shared_promise]() mutable {
+			run_continuation(state, func, *shared_promise);
+		});
+		return next;
+	}
+
+	// same, but func runs through executor.post().
+	template <typename Executor, typename Function>
+	auto then(Executor& executor, Function func) {
+		typedef conditional_t<is_void<T>::value, invoke_result<Function>, invoke_result<Function, T>> result_of;
+		typedef typename result_of::type R;
+		light_state<T>* state = take();
+		light_promise<R> promise;
+		light_future<R> next = promise.get_future();
+		auto shared_promise = make_shared<light_promise<R>>(move(promise));
+		state->on_ready([state, &executor, func = move(func), shared_promise]() mutable {
+			executor.post([state, func = move(func), shared_promise]() mutable {
+				run_continuation(state, func, *shared_promise);
+			});
+		});
+		return next;
+	}
+};
+
+template <typename T>
+light_future<T> make_ready_light_future(T value) {
+	light_promise<T> promise;
+	promise.set_value(move(value));
+	return promise.get_future();
+}
+
+/**
+ * Ready once every input is; values keep the input order.
+ * The first exception wins.
+ */
+template <typename T>
+auto when_all(vector<light_future<T>> futures) {
+	typedef conditional_t<is_void<T>::value, void, vector<T>> R;
+	struct joint {
+		light_promise<R> promise;
+		vector<optional<typename light_state<T>::stored_type>> values;
+		atomic<size_t> remaining;
+		atomic<bool> failed{false};
+		explicit joint(size_t n) : values(n), remaining(n) {}
+
+		void finish() {
+			if constexpr (is_void<T>::value) {
+				promise.set_value();
+			} else {
+				vector<T> all;
+				all.reserve(values.size());
+				for (auto& value : values) {
+					all.push_back(move(*value));
+				}
+				promise.set_value(move(all));
+			}
+		}
+	};
+	auto shared = make_shared<joint>(futures.size());
+	light_future<R> result = shared->promise.get_future();
+	if (futures.empty()) {
+		shared->finish();
+		return result;
+	}
+	for (size_t i = 0; i < futures.size(); ++i) {
+		futures[i].when_ready([shared, i](light_future<T> done) {
+			try {
+				if constexpr (is_void<T>::value) {
+					done.get();
+				} else {
+					shared->values[i].emplace(done.get());
+				}
+			} catch (...) {
+				if (!shared->failed.exchange(true)) {
+					shared->promise.set_exception(current_exception());
+				}
+			}
+			if (--shared->remaining == 0 && !shared->failed.load()) {
+				shared->finish();
+			}
+		});
+	}
+	return result;
+}
+
+#endif
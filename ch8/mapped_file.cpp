@@ -0,0 +1,63 @@
+#include "mapped_file.h"
+#include "parallel_accumulate.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// writes count uint64_t records 0, 1, 2, ... to path.
+void writeRecords(string const& path, uint64_t count) {
+	ofstream out(path, ios::binary);
+	vector<uint64_t> chunk(1 << 16);
+	for (uint64_t written = 0; written < count;) {
+		size_t const n = min<uint64_t>(chunk.size(), count - written);
+		for (size_t i = 0; i < n; ++i) {
+			chunk[i] = written + i;
+		}
+		out.write(reinterpret_cast<char const*>(chunk.data()), n * sizeof(uint64_t));
+		written += n;
+	}
+}
+
+int main(int argc, char** argv) {
+	string path = argc > 1 ? argv[1] : "/tmp/mapped_file_demo.bin";
+	if (argc <= 1) {
+		writeRecords(path, 50000000);
+	}
+
+	mapped_records<uint64_t> file;
+	try {
+		file = mapped_records<uint64_t>(path);
+	} catch (system_error const& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	cout << path << ": " << file.size() << " records" << endl;
+
+	auto start = chrono::steady_clock::now();
+	uint64_t const sum = parallel_accumulate(file.begin(), file.end(), uint64_t(0));
+	double const ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "sum " << sum << " in " << ms << " ms, "
+		<< file.size() * sizeof(uint64_t) / ms / 1e6 << " GB/s" << endl;
+
+	start = chrono::steady_clock::now();
+	uint64_t const pageSum = parallel_reduce(file, uint64_t(0), plus<uint64_t>());
+	double const pageMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "page-aligned blocks with read-ahead: " << pageMs << " ms, agree: " << boolalpha << (pageSum == sum) << endl;
+
+	if (file.size() > 0) {
+		uint64_t const target = file.begin()[file.size() / 2];
+		uint64_t const* found = parallel_find(file.begin(), file.end(), target);
+		cout << "found record " << target << " at index " << (found - file.begin()) << endl;
+	}
+
+	if (argc <= 1) {
+		remove(path.c_str());
+	}
+	return 0;
+}
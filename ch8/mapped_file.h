@@ -0,0 +1,170 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <cerrno>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "parallel_engine.h"
+
+using namespace std;
+
+/**
+ * A read-only file of fixed-size records, mapped into memory.
+ * begin()/end() are plain pointers, so the range goes straight into
+ * parallel_accumulate, parallel_find or parallel_reduce and the page cache
+ * is read in place, without copying into a vector first.
+ * A trailing partial record is ignored.
+ */
+template <typename Record>
+class mapped_records {
+private:
+	static_assert(is_trivially_copyable<Record>::value, "records are read straight from the file");
+
+	void* m_base = nullptr;
+	size_t m_bytes = 0;
+	size_t m_count = 0;
+
+	static size_t pageSize() {
+		static size_t const size = sysconf(_SC_PAGESIZE);
+		return size;
+	}
+
+	void unmap() {
+		if (m_base) {
+			munmap(m_base, m_bytes);
+			m_base = nullptr;
+		}
+	}
+
+public:
+	// an empty range.
+	mapped_records() = default;
+
+	/**
+	 * advice is passed to madvise for the whole mapping; sequential makes
+	 * the kernel read ahead aggressively and drop pages behind the reader.
+	 */
+	explicit mapped_records(string const& path, int advice = MADV_SEQUENTIAL) {
+		int const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			throw system_error(errno, generic_category(), "open " + path);
+		}
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			int const error = errno;
+			close(fd);
+			throw system_error(error, generic_category(), "fstat " + path);
+		}
+		m_count = size_t(info.st_size) / sizeof(Record);
+		m_bytes = m_count * sizeof(Record);
+		if (m_bytes != 0) {
+			m_base = mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (m_base == MAP_FAILED) {
+				int const error = errno;
+				m_base = nullptr;
+				close(fd);
+				throw system_error(error, generic_category(), "mmap " + path);
+			}
+			madvise(m_base, m_bytes, advice);
+		}
+		// the mapping keeps the file alive.
+		close(fd);
+	}
+
+	mapped_records(mapped_records const&) = delete;
+	mapped_records& operator=(mapped_records const&) = delete;
+
+	mapped_records(mapped_records&& other) noexcept :
+			m_base(exchange(other.m_base, nullptr)), m_bytes(exchange(other.m_bytes, 0)),
+			m_count(exchange(other.m_count, 0)) {}
+
+	mapped_records& operator=(mapped_records&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			m_base = exchange(other.m_base, nullptr);
+			m_bytes = exchange(other.m_bytes, 0);
+			m_count = exchange(other.m_count, 0);
+		}
+		return *this;
+	}
+
+	~mapped_records() {
+		unmap();
+	}
+
+	Record const* begin() const {
+		return static_cast<Record const*>(m_base);
+	}
+
+	Record const* end() const {
+		return begin() + m_count;
+	}
+
+	size_t size() const {
+		return m_count;
+	}
+
+	/**
+	 * Blocks that start on page boundaries, so no page is faulted in
+	 * by two threads. For parallel_reduce and parallel_blocks.
+	 */
+	block_partition blocks(unsigned long hardware_threads = thread::hardware_concurrency()) const {
+		unsigned long const records_per_page = lcm(pageSize(), sizeof(Record)) / sizeof(Record);
+		return block_partition(m_count, hardware_threads, records_per_page, records_per_page);
+	}
+
+	// asks the kernel to start reading [first, last) in now.
+	void prefetch(Record const* first, Record const* last) const {
+		uintptr_t const page_mask = ~uintptr_t(pageSize() - 1);
+		uintptr_t const from = reinterpret_cast<uintptr_t>(first) & page_mask;
+		uintptr_t const to = reinterpret_cast<uintptr_t>(last);
+		if (to > from) {
+			madvise(reinterpret_cast<void*>(from), to - from, MADV_WILLNEED);
+		}
+	}
+};
+
+// how far ahead of itself each block asks for its pages.
+inline constexpr size_t mapped_read_ahead = 2 << 20;
+
+/**
+ * parallel_reduce over page-aligned blocks of the file. Each block reads
+ * its range in windows and prefetches the next window while reducing the
+ * current one, so a cold file is read from disk in parallel with the work
+ * instead of one page fault at a time.
+ */
+template <typename Record, typename T, typename BinaryOp>
+T parallel_reduce(mapped_records<Record> const& file, T init, BinaryOp op,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	block_partition const blocks = file.blocks(hardware_threads);
+	vector<padded_result<T>> results(blocks.num_blocks);
+	size_t const window = max<size_t>(1, mapped_read_ahead / sizeof(Record));
+	parallel_blocks(file.begin(), file.end(), blocks, [&](unsigned long index, Record const* block_first, Record const* block_last) {
+		Record const* window_last = block_first + min<size_t>(window, block_last - block_first);
+		file.prefetch(block_first, window_last);
+		T partial = *block_first++;
+		while (block_first != block_last) {
+			file.prefetch(window_last, window_last + min<size_t>(window, block_last - window_last));
+			for (; block_first != window_last; ++block_first) {
+				partial = op(move(partial), *block_first);
+			}
+			window_last += min<size_t>(window, block_last - window_last);
+		}
+		results[index].value.emplace(move(partial));
+	});
+	for (auto& partial : results) {
+		if (partial.value) {
+			init = op(move(init), move(*partial.value));
+		}
+	}
+	return init;
+}
+
+#endif
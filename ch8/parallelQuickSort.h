@@ -0,0 +1,194 @@
+#ifndef PARALLEL_QUICKSORT
+#define PARALLEL_QUICKSORT
+
+#include <iostream>
+#include <thread>
+#include <list>
+#include <vector>
+#include <atomic>
+#include "light_future.h"
+#include "join_threads.h"
+#include "trace.h"
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <mutex>
+#include <stack>
+using namespace std;
+
+template <typename valueType>
+class threadSafeStack {
+private:
+	stack<valueType> m_stack;
+	mutable mutex m_mutex;
+public:
+	threadSafeStack(){}
+	threadSafeStack(const threadSafeStack& other) {
+		lock_guard<mutex> lock(other.m_mutex);
+		m_stack = other.m_stack;
+	}
+	threadSafeStack& operator=(const threadSafeStack&) = delete;
+
+	void push(valueType value) {
+		TRACE_LOCK(lock_guard<mutex> lock(m_mutex));
+		TRACE_INSTANT("stack push");
+		m_stack.push(move(value));
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		TRACE_LOCK(lock_guard<mutex> lock(m_mutex));
+		TRACE_INSTANT("stack push");
+		m_stack.emplace(forward<Args>(args)...);
+	}
+
+	shared_ptr<valueType> pop() {
+		lock_guard<mutex> lock(m_mutex);
+		if (m_stack.empty()) {
+			cout << "empty" << endl;
+			return shared_ptr<valueType>();
+		}
+		shared_ptr<valueType> const res(make_shared<valueType>(move(m_stack.top())));
+		m_stack.pop();
+		return res;
+	}
+
+	void pop(valueType& value) {
+		lock_guard<mutex> lock(m_mutex);
+		if (m_stack.empty()) {
+			return;
+			// throw emptyStack();
+		}
+		value = move(m_stack.top());
+		m_stack.pop();
+	}
+
+	optional<valueType> try_pop() {
+		TRACE_LOCK(lock_guard<mutex> lock(m_mutex));
+		if (m_stack.empty()) {
+			return nullopt;
+		}
+		TRACE_INSTANT("stack pop");
+		optional<valueType> res(move_if_noexcept(m_stack.top()));
+		m_stack.pop();
+		return res;
+	}
+
+	bool empty() const {
+		lock_guard<mutex> lock(m_mutex);
+		return m_stack.empty();
+	}
+};
+
+template <typename value_type>
+class Sorter {
+public:
+	struct chunkToSort {
+		list<value_type> data;
+		// for asynchronism
+		light_promise<list<value_type>> Promise;
+	};
+
+	threadSafeStack<chunkToSort> chunks;
+	vector<thread> threads;
+	// doSort runs on the workers too, so growing threads needs the lock.
+	mutex threadsMutex;
+	atomic<unsigned> threadCount{0};
+	unsigned const maxThreadCount;
+	atomic<bool> endOfData{false};
+	// last member, so the threads are joined before anything they use goes away.
+	join_threads joiner;
+	
+public:
+	Sorter(unsigned const hardwareThreads = thread::hardware_concurrency()) :
+			maxThreadCount(hardwareThreads != 0 ? hardwareThreads - 1 : 1), joiner(threads) {
+		// doSort runs on the constructing thread.
+		joiner.place_caller();
+	}
+
+	~Sorter() {
+		endOfData = true;
+	}
+
+	list<value_type> doSort(list<value_type>& chunkData) {
+		if (chunkData.empty()) {
+			return chunkData;
+		}
+
+		list<value_type> result;
+		result.splice(result.begin(), chunkData, chunkData.begin());
+		value_type const& pivot = *result.begin();
+
+		typename list<value_type>::iterator dividePoint = partition(chunkData.begin(), chunkData.end(), [&pivot](const value_type& value) {
+			return pivot > value;
+		});
+
+		chunkToSort newLowerChunk;
+		newLowerChunk.data.splice(newLowerChunk.data.end(), chunkData, chunkData.begin(), dividePoint);
+		
+		auto newLowerFuture = newLowerChunk.Promise.get_future();
+		chunks.push(move(newLowerChunk));
+
+		// allocate thread to process.
+		if (threadCount.load(memory_order_relaxed) < maxThreadCount) {
+			lock_guard<mutex> lock(threadsMutex);
+			if (threads.size() < maxThreadCount) {
+				threads.push_back(thread(&Sorter<value_type>::sortThread, this));
+				joiner.place(threads.size() - 1);
+				threadCount.store(threads.size(), memory_order_relaxed);
+			}
+		}
+
+		// recursion.
+		list<value_type> newHigher(doSort(chunkData));
+
+		result.splice(result.end(), newHigher);
+
+		// when this thread are waiting, it can help by processing other data.
+		// with nothing left to take, another thread holds the lower chunk: sleep until it is done.
+		while (!newLowerFuture.is_ready()) {
+			if (!trySortChunk()) {
+				newLowerFuture.wait();
+			}
+		}
+
+		result.splice(result.begin(), newLowerFuture.get());
+
+		return result;
+	}
+	
+	void sortThread() {
+		while (!endOfData) {
+			trySortChunk();
+			// suspent this.
+			// the os will schedule this thread.
+			this_thread::yield();
+		}
+	}
+
+	bool trySortChunk() {
+		optional<chunkToSort> chunk = chunks.try_pop();
+		if (chunk) {
+			sortChunk(*chunk);
+		}
+		return bool(chunk);
+	}
+
+	void sortChunk(chunkToSort& chunk) {
+		TRACE_SCOPE("sortChunk");
+		chunk.Promise.set_value(doSort(chunk.data));
+	}
+
+};
+
+template <typename value_type>
+list<value_type> parallelQuickSort(list<value_type> input,
+		unsigned const hardwareThreads = thread::hardware_concurrency()) {
+	if (input.empty()) {
+		return input;
+	}
+	Sorter<value_type> s(hardwareThreads);
+	return s.doSort(input);
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef PARALLEL_ACCUMULATE
+#define PARALLEL_ACCUMULATE
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <future>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include "join_threads.h"
+#include "light_future.h"
+#include "parallel_engine.h"
+#include "deterministic_reduce.h"
+
+using namespace std;
+
+template <typename Iterator, typename T>
+T parallel_accumulate(Iterator begin, Iterator end, T init,
+		unsigned long const hardware_threads = thread::hardware_concurrency()) {
+	return parallel_reduce(begin, end, init, plus<T>(), hardware_threads);
+}
+
+/**
+ * The same sum on any machine and with any thread count,
+ * for floating-point data that has to be reproducible.
+ */
+template <typename Iterator, typename T>
+T parallel_accumulate(Iterator begin, Iterator end, T init, summation mode,
+		unsigned long const hardware_threads = thread::hardware_concurrency()) {
+	return deterministic_sum(begin, end, init, mode, hardware_threads);
+}
+
+/**
+ * Every block stops as soon as any of them has found a match.
+ */
+template <typename Iterator, typename T>
+Iterator parallel_find(Iterator begin, Iterator end, T match,
+		unsigned long const hardware_threads = thread::hardware_concurrency()) {
+	atomic<bool> done_flag(false);
+	Iterator result = end;
+	parallel_blocks(begin, end, [&](unsigned long, Iterator block_begin, Iterator block_end) {
+		for (; block_begin != block_end && !done_flag.load(); block_begin++) {
+			if (*block_begin == match) {
+				bool expected = false;
+				if (done_flag.compare_exchange_strong(expected, true)) {
+					result = block_begin;
+				}
+				return;
+			}
+		}
+	}, hardware_threads);
+	return result;
+}
+
+template <typename Iterator>
+void parallel_partial_sum(Iterator begin, Iterator end,
+		unsigned long const hardware_threads = thread::hardware_concurrency()) {
+	typedef typename Iterator::value_type value_type;
+
+	struct process_chunk {
+		void operator()(Iterator begin, Iterator last, 
+						light_future<value_type>* previous_end_value,
+						light_promise<value_type>* end_value) {
+			try {
+				Iterator end = last;
+				end++;
+				partial_sum(begin, end, begin);
+				if (previous_end_value) {
+					/**
+					 * get: will guarantee the the value will be got.
+					 * If ann exception are thrown, it will be rethrown.
+					 * And propagate all exceptions into the final chunk.
+					 */
+					value_type append = previous_end_value->get();
+					*last += append;
+					if (end_value) {
+						end_value->set_value(*last);
+					}
+					for_each(begin, last, [append](value_type& item) {
+						item += append;
+					});
+				} else if (end_value) {
+					end_value->set_value(*last);
+				}
+			} catch (...) {
+				if (end_value) {
+					end_value->set_exception(current_exception());
+				} else {
+					throw;
+				}
+			}
+		}
+	};
+
+	unsigned long const length = distance(begin, end);
+	if (length == 0) {
+		return;
+	}
+	block_partition const blocks(length, hardware_threads);
+	unsigned long const num_threads = blocks.num_blocks;
+	unsigned long const block_size = blocks.block_size;
+	std::vector<thread> threads(num_threads - 1);
+	std::vector<light_promise<value_type>> end_values(num_threads - 1);
+	std::vector<light_future<value_type>> previous_end_values;
+	previous_end_values.reserve(num_threads - 1);
+	join_threads joiner(threads);
+	joiner.place_caller();
+
+	Iterator block_start = begin;
+	for (unsigned long i = 0; i < num_threads - 1; ++i) {
+		Iterator block_last = block_start;
+		advance(block_last, block_size - 1);
+		threads[i] = thread(process_chunk(), block_start, block_last,
+							(i != 0) ? &previous_end_values[i - 1] : 0,
+							&end_values[i]);
+		joiner.place(i);
+		block_start = block_last;
+		block_start++;
+		previous_end_values.push_back(end_values[i].get_future());
+	}
+	Iterator final_element = block_start;
+	advance(final_element, distance(block_start, end) - 1);
+	process_chunk()(block_start, final_element, (num_threads > 1) ? &previous_end_values.back() : 0, 0);
+}
+
+struct barrier {
+	atomic<unsigned> count;
+	atomic<unsigned> spaces;
+	atomic<unsigned> generation;
+
+	barrier(int _count): count(_count), spaces(_count), generation(0) {}
+
+	void wait() {
+		unsigned const myGeneration = generation.load();
+		if (!--spaces) {
+			spaces = count.load();
+			generation++;
+		} else {
+			while (myGeneration == generation.load()) {
+				this_thread::yield();
+			}
+		}
+	}
+
+	void done_waiting() {
+		count--;
+		if (!--spaces) {
+			spaces = count.load();
+			generation++;
+		}
+	}
+};
+
+// template <typename Iterator>
+// void parallel_partial_sum(Iterator begin, Iterator end) {
+// 	typedef typename Iterator::value_type value_type;
+
+// 	struct process_element {
+// 		void operator()(Iterator first, Iterator last,
+// 						std::vector<value_type>& buffer,
+// 						unsigned i, barrier& b) {
+			
+// 		}
+// 	};
+// }
+
+#endif
@@ -0,0 +1,46 @@
+#include "parallel_engine.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+	vector<int> values(100000);
+	parallel_for(values.begin(), values.end(), [](int& value) {
+		value = 1;
+	});
+
+	vector<long> squares(values.size());
+	int index = 0;
+	for (int& value : values) {
+		value = index++ % 1000;
+	}
+	parallel_transform(values.begin(), values.end(), squares.begin(), [](int value) {
+		return long(value) * value;
+	});
+
+	cout << "sum of squares: " << parallel_reduce(squares.begin(), squares.end(), 0L, plus<long>()) << endl;
+	cout << "min: " << *parallel_min_element(values.begin(), values.end())
+		<< ", max: " << *parallel_max_element(values.begin(), values.end()) << endl;
+
+	// op only has to be associative, string concatenation keeps its order.
+	vector<string> words(200, "ab");
+	string joined = parallel_reduce(words.begin(), words.end(), string(), [](string lhs, string const& rhs) {
+		return lhs + rhs;
+	});
+	cout << "joined length: " << joined.size() << ", starts with: " << joined.substr(0, 6) << endl;
+
+	try {
+		parallel_for(values.begin(), values.end(), [](int value) {
+			if (value == 999) {
+				throw runtime_error("bad element");
+			}
+		});
+	} catch (exception const& e) {
+		cout << "caught: " << e.what() << endl;
+	}
+	return 0;
+}
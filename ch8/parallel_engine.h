@@ -0,0 +1,192 @@
+#ifndef PARALLEL_ENGINE
+#define PARALLEL_ENGINE
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "join_threads.h"
+
+using namespace std;
+
+/**
+ * How a range is cut up: one block per hardware thread,
+ * but never blocks smaller than min_per_block elements.
+ * With a granularity every block but the last is a multiple of it,
+ * e.g. the records in a page of a mapped file.
+ */
+struct block_partition {
+	unsigned long length;
+	unsigned long num_blocks;
+	unsigned long block_size;
+
+	explicit block_partition(unsigned long length_,
+			unsigned long hardware_threads = thread::hardware_concurrency(),
+			unsigned long min_per_block = 25, unsigned long granularity = 1) : length(length_) {
+		unsigned long const max_blocks = (length + min_per_block - 1) / min_per_block;
+		num_blocks = max(1ul, min(hardware_threads != 0 ? hardware_threads : 2, max_blocks));
+		block_size = length / num_blocks;
+		if (granularity > 1 && num_blocks > 1) {
+			block_size = (block_size + granularity - 1) / granularity * granularity;
+			num_blocks = (length + block_size - 1) / block_size;
+		}
+	}
+};
+
+// lets plain indices stand in for iterators.
+template <typename Iterator>
+void advance_by(Iterator& it, unsigned long n) {
+	if constexpr (is_integral<Iterator>::value) {
+		it += n;
+	} else {
+		advance(it, n);
+	}
+}
+
+/**
+ * Runs func(block_index, block_first, block_last) for every block,
+ * the last block on the calling thread. Threads are joined even if
+ * something throws; afterwards the first worker exception is rethrown.
+ */
+template <typename Iterator, typename BlockFunction>
+void parallel_blocks(Iterator first, Iterator last, block_partition const& blocks, BlockFunction const& func) {
+	if (blocks.length == 0) {
+		return;
+	}
+	vector<future<void>> futures(blocks.num_blocks - 1);
+	vector<thread> threads(blocks.num_blocks - 1);
+	{
+		join_threads joiner(threads);
+		joiner.place_caller();
+		Iterator block_start = first;
+		for (unsigned long i = 0; i < blocks.num_blocks - 1; ++i) {
+			Iterator block_end = block_start;
+			advance_by(block_end, blocks.block_size);
+			packaged_task<void()> task([&func, i, block_start, block_end]() {
+				TRACE_SCOPE("block");
+				func(i, block_start, block_end);
+			});
+			futures[i] = task.get_future();
+			threads[i] = thread(move(task));
+			joiner.place(i);
+			block_start = block_end;
+		}
+		{
+			TRACE_SCOPE("block");
+			func(blocks.num_blocks - 1, block_start, last);
+		}
+	}
+	for (auto& f : futures) {
+		f.get();
+	}
+}
+
+template <typename Iterator, typename BlockFunction>
+void parallel_blocks(Iterator first, Iterator last, BlockFunction const& func,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	parallel_blocks(first, last, block_partition(distance(first, last), hardware_threads), func);
+}
+
+template <typename Iterator, typename Function>
+void parallel_for(Iterator first, Iterator last, Function func,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	parallel_blocks(first, last, [&func](unsigned long, Iterator block_first, Iterator block_last) {
+		for_each(block_first, block_last, func);
+	}, hardware_threads);
+}
+
+/**
+ * Every block writes to its own part of the destination, so d_first must be
+ * a forward iterator into a range that is already big enough;
+ * back_inserter or ostream_iterator won't do.
+ */
+template <typename Iterator, typename ForwardIterator, typename Function>
+ForwardIterator parallel_transform(Iterator first, Iterator last, ForwardIterator d_first, Function op,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	static_assert(is_base_of<forward_iterator_tag, typename iterator_traits<ForwardIterator>::iterator_category>::value,
+		"parallel_transform writes blocks in parallel and needs a forward destination iterator");
+	block_partition const blocks(distance(first, last), hardware_threads);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		ForwardIterator out = d_first;
+		advance(out, index * blocks.block_size);
+		transform(block_first, block_last, out, op);
+	});
+	advance(d_first, blocks.length);
+	return d_first;
+}
+
+// one per block, so block results written side by side don't share a cache line.
+template <typename T>
+struct alignas(64) padded_result {
+	optional<T> value;
+};
+
+/**
+ * op must be associative; it need not be commutative, since the block
+ * results are folded left to right after init. op has no identity
+ * element here, so each block starts from its own first element.
+ */
+template <typename Iterator, typename T, typename BinaryOp>
+T parallel_reduce(Iterator first, Iterator last, T init, BinaryOp op, block_partition const& blocks) {
+	vector<padded_result<T>> results(blocks.num_blocks);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		T partial = *block_first;
+		for (++block_first; block_first != block_last; ++block_first) {
+			partial = op(move(partial), *block_first);
+		}
+		results[index].value.emplace(move(partial));
+	});
+	for (auto& partial : results) {
+		if (partial.value) {
+			init = op(move(init), move(*partial.value));
+		}
+	}
+	return init;
+}
+
+template <typename Iterator, typename T, typename BinaryOp>
+T parallel_reduce(Iterator first, Iterator last, T init, BinaryOp op,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	return parallel_reduce(first, last, init, op, block_partition(distance(first, last), hardware_threads));
+}
+
+template <typename Iterator, typename Compare = less<>>
+Iterator parallel_min_element(Iterator first, Iterator last, Compare comp = Compare(),
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	block_partition const blocks(distance(first, last), hardware_threads);
+	vector<Iterator> mins(blocks.num_blocks, last);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		mins[index] = min_element(block_first, block_last, comp);
+	});
+	Iterator best = last;
+	for (Iterator candidate : mins) {
+		if (candidate != last && (best == last || comp(*candidate, *best))) {
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+template <typename Iterator, typename Compare = less<>>
+Iterator parallel_max_element(Iterator first, Iterator last, Compare comp = Compare(),
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	// the first of several equal maxima, like std::max_element.
+	block_partition const blocks(distance(first, last), hardware_threads);
+	vector<Iterator> maxs(blocks.num_blocks, last);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		maxs[index] = max_element(block_first, block_last, comp);
+	});
+	Iterator best = last;
+	for (Iterator candidate : maxs) {
+		if (candidate != last && (best == last || comp(*best, *candidate))) {
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#include "parallel_partition.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+int main() {
+	vector<int> data(10000000);
+	mt19937 rng(7);
+	generate(data.begin(), data.end(), [&]() { return int(rng() % 1000); });
+	vector<int> copy = data;
+	auto below = [](int value) { return value < 300; };
+
+	auto start = chrono::steady_clock::now();
+	auto middle = parallel_partition(data.begin(), data.end(), below);
+	double parallelMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	auto expected = partition(copy.begin(), copy.end(), below);
+	double serialMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	cout << "split at " << (middle - data.begin()) << " (std: " << (expected - copy.begin()) << "), partitioned: "
+		<< boolalpha << is_partitioned(data.begin(), data.end(), below) << endl;
+	cout << "parallel " << parallelMs << " ms, std::partition " << serialMs << " ms" << endl;
+
+	// the stable version keeps the original order on both sides.
+	vector<pair<int, int>> records;
+	for (int i = 0; i < 100000; ++i) {
+		records.push_back({int(rng() % 10), i});
+	}
+	vector<pair<int, int>> reference = records;
+	auto even = [](pair<int, int> const& record) { return record.first % 2 == 0; };
+	parallel_stable_partition(records.begin(), records.end(), even);
+	stable_partition(reference.begin(), reference.end(), even);
+	cout << "stable matches std::stable_partition: " << (records == reference) << endl;
+	return 0;
+}
@@ -0,0 +1,158 @@
+#ifndef PARALLEL_PARTITION
+#define PARALLEL_PARTITION
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel_engine.h"
+
+using namespace std;
+
+/**
+ * Like std::partition on a random-access range, every pass split across threads:
+ *  1. each block is partitioned on its own,
+ *  2. the elements on the wrong side of the final split point are listed
+ *     as ranges; there are as many misplaced falses on the left as
+ *     misplaced trues on the right,
+ *  3. the k-th misplaced left element is swapped with the k-th right one,
+ *     with k split over the threads again.
+ * pred is called once per element.
+ */
+template <typename Iterator, typename Predicate>
+Iterator parallel_partition(Iterator first, Iterator last, Predicate pred,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	typedef pair<unsigned long, unsigned long> index_range;
+
+	unsigned long const length = last - first;
+	block_partition const blocks(length, hardware_threads);
+	if (blocks.num_blocks <= 1) {
+		return partition(first, last, pred);
+	}
+
+	vector<unsigned long> block_begin(blocks.num_blocks + 1);
+	for (unsigned long i = 0; i < blocks.num_blocks; ++i) {
+		block_begin[i] = i * blocks.block_size;
+	}
+	block_begin[blocks.num_blocks] = length;
+
+	vector<unsigned long> block_middle(blocks.num_blocks);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		block_middle[index] = partition(block_first, block_last, pred) - first;
+	});
+
+	unsigned long split = 0;
+	for (unsigned long i = 0; i < blocks.num_blocks; ++i) {
+		split += block_middle[i] - block_begin[i];
+	}
+
+	vector<index_range> wrong_left, wrong_right;
+	for (unsigned long i = 0; i < blocks.num_blocks; ++i) {
+		unsigned long const middle = block_middle[i];
+		unsigned long const end = block_begin[i + 1];
+		// falses that belong right of split.
+		if (middle < split && middle < end) {
+			wrong_left.push_back({middle, min(end, split)});
+		}
+		// trues that belong left of split.
+		unsigned long const begin = max(block_begin[i], split);
+		if (begin < middle) {
+			wrong_right.push_back({begin, middle});
+		}
+	}
+
+	vector<unsigned long> left_offsets(wrong_left.size() + 1, 0), right_offsets(wrong_right.size() + 1, 0);
+	for (size_t i = 0; i < wrong_left.size(); ++i) {
+		left_offsets[i + 1] = left_offsets[i] + wrong_left[i].second - wrong_left[i].first;
+	}
+	for (size_t i = 0; i < wrong_right.size(); ++i) {
+		right_offsets[i + 1] = right_offsets[i] + wrong_right[i].second - wrong_right[i].first;
+	}
+	unsigned long const misplaced = left_offsets.back();
+
+	// position of the k-th element of a range list, and a cursor to walk on from there.
+	auto locate = [](vector<index_range> const& ranges, vector<unsigned long> const& offsets, unsigned long k) {
+		size_t const range = upper_bound(offsets.begin(), offsets.end(), k) - offsets.begin() - 1;
+		return make_pair(range, ranges[range].first + (k - offsets[range]));
+	};
+
+	parallel_blocks(0ul, misplaced, block_partition(misplaced, hardware_threads),
+		[&](unsigned long, unsigned long k_first, unsigned long k_last) {
+			if (k_first == k_last) {
+				return;
+			}
+			auto left = locate(wrong_left, left_offsets, k_first);
+			auto right = locate(wrong_right, right_offsets, k_first);
+			for (unsigned long k = k_first; k < k_last; ++k) {
+				if (left.second == wrong_left[left.first].second) {
+					++left.first;
+					left.second = wrong_left[left.first].first;
+				}
+				if (right.second == wrong_right[right.first].second) {
+					++right.first;
+					right.second = wrong_right[right.first].first;
+				}
+				iter_swap(first + left.second++, first + right.second++);
+			}
+		});
+	return first + split;
+}
+
+/**
+ * Keeps the relative order on both sides, like std::stable_partition.
+ * Each block is stable-partitioned in place, then every block moves its
+ * two halves to their final offsets in a buffer, and the buffer is moved
+ * back, both in parallel. Needs a nothrow move so the buffer passes
+ * cannot fail half way.
+ */
+template <typename Iterator, typename Predicate>
+Iterator parallel_stable_partition(Iterator first, Iterator last, Predicate pred,
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	typedef typename iterator_traits<Iterator>::value_type value_type;
+	static_assert(is_nothrow_move_constructible<value_type>::value, "parallel_stable_partition moves through a buffer");
+
+	unsigned long const length = last - first;
+	block_partition const blocks(length, hardware_threads);
+	if (blocks.num_blocks <= 1) {
+		return stable_partition(first, last, pred);
+	}
+
+	vector<unsigned long> true_count(blocks.num_blocks);
+	vector<Iterator> block_middle(blocks.num_blocks);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		block_middle[index] = stable_partition(block_first, block_last, pred);
+		true_count[index] = block_middle[index] - block_first;
+	});
+
+	vector<unsigned long> true_offset(blocks.num_blocks), false_offset(blocks.num_blocks);
+	unsigned long split = 0;
+	for (unsigned long i = 0; i < blocks.num_blocks; ++i) {
+		true_offset[i] = split;
+		split += true_count[i];
+	}
+	unsigned long falses = split;
+	for (unsigned long i = 0; i < blocks.num_blocks; ++i) {
+		false_offset[i] = falses;
+		unsigned long const block_length = i + 1 < blocks.num_blocks ? blocks.block_size : length - i * blocks.block_size;
+		falses += block_length - true_count[i];
+	}
+
+	allocator<value_type> alloc;
+	value_type* buffer = alloc.allocate(length);
+	parallel_blocks(first, last, blocks, [&](unsigned long index, Iterator block_first, Iterator block_last) {
+		uninitialized_move(block_first, block_middle[index], buffer + true_offset[index]);
+		uninitialized_move(block_middle[index], block_last, buffer + false_offset[index]);
+	});
+	parallel_blocks(first, last, blocks, [&](unsigned long, Iterator block_first, Iterator block_last) {
+		value_type* source = buffer + (block_first - first);
+		move(source, source + (block_last - block_first), block_first);
+		destroy(source, source + (block_last - block_first));
+	});
+	alloc.deallocate(buffer, length);
+	return first + split;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "parallel_radix_sort.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+struct record {
+	uint64_t id;
+	double payload;
+};
+
+template <typename Function>
+double timeMs(Function func) {
+	auto start = chrono::steady_clock::now();
+	func();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	size_t const count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+	mt19937_64 rng(42);
+
+	vector<uint32_t> keys(count);
+	for (auto& k : keys) {
+		k = uint32_t(rng());
+	}
+	vector<uint32_t> expected = keys;
+	double radixMs = timeMs([&]() { parallel_radix_sort(keys.begin(), keys.end()); });
+	double sortMs = timeMs([&]() { sort(expected.begin(), expected.end()); });
+	cout << count << " uint32: radix " << radixMs << " ms, std::sort " << sortMs << " ms, equal: "
+		<< boolalpha << (keys == expected) << endl;
+
+	vector<int64_t> signedKeys(count / 10);
+	for (auto& k : signedKeys) {
+		k = int64_t(rng()) >> (rng() % 40);
+	}
+	parallel_radix_sort(signedKeys.begin(), signedKeys.end());
+	cout << "int64 sorted: " << is_sorted(signedKeys.begin(), signedKeys.end()) << endl;
+
+	// records sort by an extracted key and keep their order among equal keys.
+	vector<record> records(count / 10);
+	for (size_t i = 0; i < records.size(); ++i) {
+		records[i] = {rng() % 1000, double(i)};
+	}
+	parallel_radix_sort(records.begin(), records.end(), [](record const& r) { return r.id; });
+	bool stable = is_sorted(records.begin(), records.end(), [](record const& lhs, record const& rhs) {
+		return lhs.id != rhs.id ? lhs.id < rhs.id : lhs.payload < rhs.payload;
+	});
+	cout << "records sorted and stable: " << stable << endl;
+
+	vector<array<unsigned char, 6>> byteKeys(count / 10);
+	for (auto& k : byteKeys) {
+		for (auto& c : k) {
+			c = rng() % 4;
+		}
+	}
+	parallel_radix_sort(byteKeys.begin(), byteKeys.end());
+	cout << "byte keys sorted: " << is_sorted(byteKeys.begin(), byteKeys.end()) << endl;
+	return 0;
+}
@@ -0,0 +1,155 @@
+#ifndef PARALLEL_RADIX_SORT
+#define PARALLEL_RADIX_SORT
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel_engine.h"
+
+using namespace std;
+
+/**
+ * How a key splits into 8 bit digits, digit 0 being the least significant.
+ * Specialize it for other fixed-width keys.
+ */
+template <typename Key, typename Enable = void>
+struct radix_traits;
+
+template <typename Key>
+struct radix_traits<Key, typename enable_if<is_integral<Key>::value>::type> {
+	static constexpr unsigned digits = sizeof(Key);
+
+	static unsigned digit(Key key, unsigned d) {
+		typedef typename make_unsigned<Key>::type unsigned_key;
+		unsigned_key bits = unsigned_key(key);
+		if (is_signed<Key>::value) {
+			// flipping the sign bit puts negative keys first.
+			bits ^= unsigned_key(1) << (sizeof(Key) * CHAR_BIT - 1);
+		}
+		return (bits >> (d * CHAR_BIT)) & 0xff;
+	}
+};
+
+// fixed-width byte strings, compared lexicographically.
+template <size_t N>
+struct radix_traits<array<unsigned char, N>> {
+	static constexpr unsigned digits = N;
+
+	static unsigned digit(array<unsigned char, N> const& key, unsigned d) {
+		return key[N - 1 - d];
+	}
+};
+
+struct identity_key {
+	template <typename T>
+	T const& operator()(T const& value) const {
+		return value;
+	}
+};
+
+/**
+ * Stable LSD radix sort on a random-access range, one pass per key byte.
+ * Every pass counts digits per block, turns the counts into per-block
+ * bucket offsets and scatters the block to the other buffer. Scattered
+ * elements are staged in a small buffer per bucket and written out a
+ * cache line at a time, so the 256 output streams don't evict each other.
+ * A pass where every key has the same digit is skipped.
+ *
+ * key(element) gives the sort key, which needs radix_traits.
+ * Elements must be default constructible for the scratch buffer.
+ */
+template <typename Iterator, typename KeyExtractor = identity_key>
+void parallel_radix_sort(Iterator first, Iterator last, KeyExtractor key = KeyExtractor(),
+		unsigned long hardware_threads = thread::hardware_concurrency()) {
+	typedef typename iterator_traits<Iterator>::value_type value_type;
+	typedef typename decay<decltype(key(*first))>::type key_type;
+	typedef radix_traits<key_type> traits;
+	static unsigned const radix = 256;
+	static unsigned const staged = max<size_t>(1, 64 / sizeof(value_type));
+
+	unsigned long const length = last - first;
+	if (length < 4096) {
+		stable_sort(first, last, [&key](value_type const& lhs, value_type const& rhs) {
+			return key(lhs) < key(rhs);
+		});
+		return;
+	}
+
+	block_partition const blocks(length, hardware_threads, 4096);
+	vector<value_type> buffer(length);
+	vector<array<unsigned long, radix>> counts(blocks.num_blocks);
+	bool in_buffer = false;
+
+	for (unsigned d = 0; d < traits::digits; ++d) {
+		// both sides of the pass, whichever holds the data right now.
+		auto pass = [&](auto source, auto target) {
+			typedef decltype(source) source_iterator;
+			parallel_blocks(source, source + length, blocks,
+				[&](unsigned long index, source_iterator block_first, source_iterator block_last) {
+					array<unsigned long, radix>& count = counts[index];
+					count.fill(0);
+					for (; block_first != block_last; ++block_first) {
+						++count[traits::digit(key(*block_first), d)];
+					}
+				});
+
+			array<unsigned long, radix> totals{};
+			for (auto const& count : counts) {
+				for (unsigned b = 0; b < radix; ++b) {
+					totals[b] += count[b];
+				}
+			}
+			if (find(totals.begin(), totals.end(), length) != totals.end()) {
+				return false;
+			}
+
+			// counts become the first output slot of each block and bucket.
+			unsigned long offset = 0;
+			for (unsigned b = 0; b < radix; ++b) {
+				for (auto& count : counts) {
+					unsigned long const n = count[b];
+					count[b] = offset;
+					offset += n;
+				}
+			}
+
+			parallel_blocks(source, source + length, blocks,
+				[&](unsigned long index, source_iterator block_first, source_iterator block_last) {
+					array<unsigned long, radix>& next = counts[index];
+					vector<value_type> staging(radix * staged);
+					array<unsigned, radix> fill{};
+					for (; block_first != block_last; ++block_first) {
+						unsigned const b = traits::digit(key(*block_first), d);
+						staging[b * staged + fill[b]] = move(*block_first);
+						if (++fill[b] == staged) {
+							move(staging.begin() + b * staged, staging.begin() + (b + 1) * staged, target + next[b]);
+							next[b] += staged;
+							fill[b] = 0;
+						}
+					}
+					for (unsigned b = 0; b < radix; ++b) {
+						move(staging.begin() + b * staged, staging.begin() + b * staged + fill[b], target + next[b]);
+					}
+				});
+			return true;
+		};
+		if (in_buffer ? pass(buffer.begin(), first) : pass(first, buffer.begin())) {
+			in_buffer = !in_buffer;
+		}
+	}
+
+	if (in_buffer) {
+		parallel_blocks(buffer.begin(), buffer.end(), blocks,
+			[&](unsigned long, typename vector<value_type>::iterator block_first,
+					typename vector<value_type>::iterator block_last) {
+				move(block_first, block_last, first + (block_first - buffer.begin()));
+			});
+	}
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef PER_THREAD_SLOTS
+#define PER_THREAD_SLOTS
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+/**
+ * The slots an object hands out one per thread, as used by combinable and
+ * flat_combining. Slot needs a thread::id owner and a Slot* next.
+ *
+ * Slots sit in a lock-free list that only grows until clear(). Every thread
+ * also caches its recent slots in a small table keyed by the owning
+ * object's id, so a thread that works with several such objects at once
+ * still finds its slot without walking the list. Ids are never reused,
+ * so a cache entry can't outlive its object and point into a new one.
+ */
+template <typename Slot>
+class per_thread_slots {
+private:
+	static unsigned const cache_size = 16;
+
+	struct cache_entry {
+		unsigned long long id = 0;
+		Slot* slot = nullptr;
+	};
+
+	static unsigned long long nextId() {
+		static atomic<unsigned long long> id{1};
+		return id.fetch_add(1, memory_order_relaxed);
+	}
+
+	// one table per thread and Slot type.
+	static cache_entry& cached(unsigned long long id) {
+		static thread_local cache_entry cache[cache_size];
+		return cache[id % cache_size];
+	}
+
+	unsigned long long m_id = nextId();
+	atomic<Slot*> m_head{nullptr};
+
+public:
+	per_thread_slots() {}
+	per_thread_slots(per_thread_slots const&) = delete;
+	per_thread_slots& operator=(per_thread_slots const&) = delete;
+
+	~per_thread_slots() {
+		clear();
+	}
+
+	// the calling thread's slot; make() creates it on first use.
+	template <typename Make>
+	Slot& local(Make make) {
+		cache_entry& entry = cached(m_id);
+		if (entry.id == m_id) {
+			return *entry.slot;
+		}
+		thread::id const self = this_thread::get_id();
+		Slot* found = nullptr;
+		for (Slot* s = m_head.load(memory_order_acquire); s; s = s->next) {
+			if (s->owner == self) {
+				found = s;
+				break;
+			}
+		}
+		if (!found) {
+			found = make();
+			found->next = m_head.load(memory_order_relaxed);
+			while (!m_head.compare_exchange_weak(found->next, found, memory_order_release, memory_order_relaxed));
+		}
+		entry.id = m_id;
+		entry.slot = found;
+		return *found;
+	}
+
+	Slot* head() const {
+		return m_head.load(memory_order_acquire);
+	}
+
+	// no thread may be using a slot; the new id invalidates what they cached.
+	void clear() {
+		m_id = nextId();
+		Slot* s = m_head.exchange(nullptr, memory_order_acquire);
+		while (s) {
+			Slot* next = s->next;
+			delete s;
+			s = next;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "sharded_queue.h"
+
+#include <iostream>
+
+using namespace std;
+
+int main() {
+	ShardedQueue<int> queue;
+	cout << "Shards: " << queue.shards() << endl;
+
+	unsigned const producers = 4;
+	int const perProducer = 100000;
+	atomic<long long> total{0};
+	vector<thread> threads;
+	for (unsigned i = 0; i < producers; ++i) {
+		threads.push_back(thread([&]() {
+			for (int value = 1; value <= perProducer; ++value) {
+				queue.push(value);
+			}
+		}));
+		threads.push_back(thread([&]() {
+			long long sum = 0;
+			for (int popped = 0; popped < perProducer; ++popped) {
+				sum += queue.wait_pop();
+			}
+			total += sum;
+		}));
+	}
+	for (auto& thd : threads) {
+		thd.join();
+	}
+	cout << total << " == " << (long long)producers * perProducer * (perProducer + 1) / 2 << endl;
+	return 0;
+}
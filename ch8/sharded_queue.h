@@ -0,0 +1,132 @@
+#ifndef SHARDED_QUEUE
+#define SHARDED_QUEUE
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "../ch4/threadSafeQueue.h"
+#include "topology.h"
+
+using namespace std;
+
+/**
+ * One ThreadSafeQueue per NUMA node (or per CPU group).
+ * Threads push to and pop from the shard of the node they are running on,
+ * and only steal from remote shards when their own one is empty.
+ * Order is FIFO per shard, not across the whole queue.
+ */
+template <typename value_type>
+class ShardedQueue {
+private:
+	// keep each shard's mutex and queue off its neighbours' cache lines.
+	struct alignas(64) Shard {
+		ThreadSafeQueue<value_type> queue;
+	};
+
+	vector<unique_ptr<Shard>> m_shards;
+	vector<unsigned> m_cpuToShard;
+
+	// only touched by consumers that found every shard empty.
+	mutex m_sleepMutex;
+	condition_variable m_sleepCv;
+	atomic<unsigned> m_sleepers{0};
+
+	unsigned localShard() const {
+		unsigned const cpu = current_cpu();
+		return cpu < m_cpuToShard.size() ? m_cpuToShard[cpu] : cpu % m_shards.size();
+	}
+
+	void wakeSleepers() {
+		if (m_sleepers.load()) {
+			lock_guard<mutex> lock(m_sleepMutex);
+			m_sleepCv.notify_all();
+		}
+	}
+
+public:
+	/**
+	 * shardCount == 0 takes one shard per NUMA node,
+	 * otherwise CPUs are spread round-robin over the given number of shards.
+	 */
+	explicit ShardedQueue(unsigned shardCount = 0) {
+		if (shardCount == 0) {
+			vector<vector<int>> const nodes = numa_nodes();
+			for (unsigned node = 0; node < nodes.size(); ++node) {
+				for (int cpu : nodes[node]) {
+					if (m_cpuToShard.size() <= unsigned(cpu)) {
+						m_cpuToShard.resize(cpu + 1, 0);
+					}
+					m_cpuToShard[cpu] = node;
+				}
+			}
+			shardCount = max<size_t>(nodes.size(), 1);
+		} else {
+			unsigned const hardwareThreads = thread::hardware_concurrency();
+			m_cpuToShard.resize(hardwareThreads != 0 ? hardwareThreads : 1);
+			for (unsigned cpu = 0; cpu < m_cpuToShard.size(); ++cpu) {
+				m_cpuToShard[cpu] = cpu % shardCount;
+			}
+		}
+		for (unsigned i = 0; i < shardCount; ++i) {
+			m_shards.emplace_back(new Shard);
+		}
+	}
+	ShardedQueue(const ShardedQueue&) = delete;
+	ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+	unsigned shards() const {
+		return m_shards.size();
+	}
+
+	void push(value_type value) {
+		m_shards[localShard()]->queue.push(move(value));
+		wakeSleepers();
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+		m_shards[localShard()]->queue.emplace(forward<Args>(args)...);
+		wakeSleepers();
+	}
+
+	optional<value_type> try_pop() {
+		unsigned const local = localShard();
+		for (unsigned i = 0; i < m_shards.size(); ++i) {
+			optional<value_type> result = m_shards[(local + i) % m_shards.size()]->queue.try_pop();
+			if (result) {
+				return result;
+			}
+		}
+		return nullopt;
+	}
+
+	value_type wait_pop() {
+		if (optional<value_type> result = try_pop()) {
+			return move(*result);
+		}
+		unique_lock<mutex> lock(m_sleepMutex);
+		// registered before the re-check, so a push after it is sure to wake us.
+		++m_sleepers;
+		optional<value_type> result;
+		while (!(result = try_pop())) {
+			m_sleepCv.wait(lock);
+		}
+		--m_sleepers;
+		return move(*result);
+	}
+
+	bool empty() const {
+		for (auto const& shard : m_shards) {
+			if (!shard->queue.empty()) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef TOPOLOGY
+#define TOPOLOGY
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+/**
+ * Parse the kernel's cpu list format, e.g. "0-3,8-11".
+ */
+inline vector<int> parse_cpu_list(string const& list) {
+	vector<int> cpus;
+	stringstream ss(list);
+	string range;
+	while (getline(ss, range, ',')) {
+		if (range.empty() || range == "\n") {
+			continue;
+		}
+		size_t const dash = range.find('-');
+		int const first = stoi(range.substr(0, dash));
+		int const last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+		for (int cpu = first; cpu <= last; ++cpu) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+inline bool read_sys_line(string const& path, string& line) {
+	ifstream file(path);
+	return file && getline(file, line);
+}
+
+/**
+ * CPUs grouped by NUMA node, read from /sys.
+ * Without NUMA information the CPUs are grouped by socket,
+ * and without that everything ends up in one group.
+ */
+inline vector<vector<int>> numa_nodes() {
+	vector<vector<int>> nodes;
+	string line;
+	if (read_sys_line("/sys/devices/system/node/online", line)) {
+		for (int node : parse_cpu_list(line)) {
+			string cpus;
+			if (read_sys_line("/sys/devices/system/node/node" + to_string(node) + "/cpulist", cpus)) {
+				vector<int> node_cpus = parse_cpu_list(cpus);
+				if (!node_cpus.empty()) {
+					nodes.push_back(node_cpus);
+				}
+			}
+		}
+	}
+	if (!nodes.empty()) {
+		return nodes;
+	}
+
+	unsigned const hardware_threads = thread::hardware_concurrency();
+	unsigned const cpu_count = hardware_threads != 0 ? hardware_threads : 1;
+	vector<int> package_of(cpu_count, 0);
+	int max_package = 0;
+	for (unsigned cpu = 0; cpu < cpu_count; ++cpu) {
+		string package;
+		if (read_sys_line("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/physical_package_id", package)) {
+			package_of[cpu] = max(0, stoi(package));
+			max_package = max(max_package, package_of[cpu]);
+		}
+	}
+	nodes.resize(max_package + 1);
+	for (unsigned cpu = 0; cpu < cpu_count; ++cpu) {
+		nodes[package_of[cpu]].push_back(cpu);
+	}
+	nodes.erase(remove_if(nodes.begin(), nodes.end(), [](vector<int> const& node) {
+		return node.empty();
+	}), nodes.end());
+	return nodes;
+}
+
+inline int current_cpu() {
+	int const cpu = sched_getcpu();
+	return cpu < 0 ? 0 : cpu;
+}
+
+/**
+ * The CPUs this process may run on, from sched_getaffinity,
+ * so a taskset or cgroup restriction is respected.
+ */
+inline vector<int> allowed_cpus() {
+	vector<int> cpus;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+			if (CPU_ISSET(cpu, &set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+	if (cpus.empty()) {
+		unsigned const hardware_threads = thread::hardware_concurrency();
+		for (unsigned cpu = 0; cpu < max(1u, hardware_threads); ++cpu) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+struct cpu_info {
+	int cpu;
+	// lowest CPU number of the physical core, shared by its SMT siblings.
+	int core;
+	// position among the core's SMT siblings, 0 for the first.
+	int sibling;
+	// index into numa_nodes().
+	int node;
+};
+
+inline vector<cpu_info> cpu_topology() {
+	vector<vector<int>> const nodes = numa_nodes();
+	vector<cpu_info> topology;
+	for (int cpu : allowed_cpus()) {
+		cpu_info info{cpu, cpu, 0, 0};
+		string line;
+		if (read_sys_line("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/thread_siblings_list", line)) {
+			vector<int> const siblings = parse_cpu_list(line);
+			if (!siblings.empty()) {
+				info.core = siblings.front();
+				info.sibling = find(siblings.begin(), siblings.end(), cpu) - siblings.begin();
+			}
+		}
+		for (size_t node = 0; node < nodes.size(); ++node) {
+			if (find(nodes[node].begin(), nodes[node].end(), cpu) != nodes[node].end()) {
+				info.node = node;
+			}
+		}
+		topology.push_back(info);
+	}
+	return topology;
+}
+
+/**
+ * Where worker threads go:
+ *  compact        - fill a core's SMT siblings, then the next core of the same node,
+ *                   so neighbouring blocks share caches,
+ *  scatter        - one thread per core round robin over the nodes, siblings last,
+ *                   for the most memory bandwidth,
+ *  physical_cores - only the first sibling of every core, no SMT contention.
+ *                   Size the thread count with placement_thread_count().
+ */
+enum class placement { none, compact, scatter, physical_cores };
+
+inline vector<int> make_placement_order(placement policy) {
+	vector<cpu_info> topology = cpu_topology();
+	vector<int> order;
+	if (policy == placement::none) {
+		return order;
+	}
+	if (policy == placement::physical_cores) {
+		topology.erase(remove_if(topology.begin(), topology.end(), [](cpu_info const& info) {
+			return info.sibling != 0;
+		}), topology.end());
+	}
+	sort(topology.begin(), topology.end(), [policy](cpu_info const& lhs, cpu_info const& rhs) {
+		if (policy == placement::scatter && lhs.sibling != rhs.sibling) {
+			return lhs.sibling < rhs.sibling;
+		}
+		if (lhs.node != rhs.node) {
+			return lhs.node < rhs.node;
+		}
+		if (lhs.core != rhs.core) {
+			return lhs.core < rhs.core;
+		}
+		return lhs.cpu < rhs.cpu;
+	});
+	if (policy == placement::scatter) {
+		// deal the cores of each sibling rank out over the nodes.
+		vector<cpu_info> dealt;
+		for (auto rank_first = topology.begin(); rank_first != topology.end();) {
+			auto const rank_last = find_if(rank_first, topology.end(), [&](cpu_info const& info) {
+				return info.sibling != rank_first->sibling;
+			});
+			vector<vector<cpu_info>> by_node;
+			for (auto it = rank_first; it != rank_last; ++it) {
+				if (by_node.size() <= size_t(it->node)) {
+					by_node.resize(it->node + 1);
+				}
+				by_node[it->node].push_back(*it);
+			}
+			for (size_t i = 0; dealt.size() < size_t(rank_last - topology.begin()); ++i) {
+				for (auto const& node : by_node) {
+					if (i < node.size()) {
+						dealt.push_back(node[i]);
+					}
+				}
+			}
+			rank_first = rank_last;
+		}
+		topology = dealt;
+	}
+	for (cpu_info const& info : topology) {
+		order.push_back(info.cpu);
+	}
+	return order;
+}
+
+// read once, the topology doesn't change under a running process.
+inline vector<int> const& placement_order(placement policy) {
+	static vector<int> const orders[] = {
+		vector<int>(),
+		make_placement_order(placement::compact),
+		make_placement_order(placement::scatter),
+		make_placement_order(placement::physical_cores),
+	};
+	return orders[static_cast<int>(policy)];
+}
+
+/**
+ * Process-wide policy for the thread groups of the parallel algorithms.
+ * none leaves scheduling to the OS, which is the default.
+ */
+inline atomic<placement>& thread_placement_setting() {
+	static atomic<placement> setting{placement::none};
+	return setting;
+}
+
+inline placement thread_placement() {
+	return thread_placement_setting().load(memory_order_relaxed);
+}
+
+inline void set_thread_placement(placement policy) {
+	thread_placement_setting().store(policy, memory_order_relaxed);
+}
+
+inline unsigned placement_thread_count(placement policy = thread_placement()) {
+	vector<int> const& order = placement_order(policy);
+	if (!order.empty()) {
+		return order.size();
+	}
+	unsigned const hardware_threads = thread::hardware_concurrency();
+	return hardware_threads != 0 ? hardware_threads : 2;
+}
+
+inline bool pin_thread(pthread_t handle, int cpu) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+}
+
+inline bool pin_thread(thread& t, int cpu) {
+	return pin_thread(t.native_handle(), cpu);
+}
+
+#endif
@@ -0,0 +1,33 @@
+// g++ -std=c++17 -O2 -pthread -DPARALLEL_TRACE ch8/trace.cpp && ./a.out
+// then load parallel_trace.json in chrome://tracing or ui.perfetto.dev.
+#include "trace.h"
+#include "parallelQuickSort.h"
+#include "parallel_engine.h"
+
+#include <iostream>
+#include <list>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+int main() {
+	mt19937 rng(1);
+	list<int> input;
+	for (int i = 0; i < 20000; ++i) {
+		input.push_back(rng() % 100000);
+	}
+	list<int> sorted = parallelQuickSort(input, 4);
+
+	vector<double> values(1000000, 1.5);
+	double const sum = parallel_reduce(values.begin(), values.end(), 0.0, plus<double>(), 4);
+	cout << "sorted " << sorted.size() << " values, sum " << sum << endl;
+
+#if defined(PARALLEL_TRACE)
+	trace_write_chrome_json("parallel_trace.json");
+	cout << "trace written to parallel_trace.json" << endl;
+#else
+	cout << "built without -DPARALLEL_TRACE, nothing was traced" << endl;
+#endif
+	return 0;
+}
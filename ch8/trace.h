@@ -0,0 +1,177 @@
+#ifndef TRACE
+#define TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+/**
+ * Opt-in event tracing for the threads of the parallel algorithms.
+ * Build with -DPARALLEL_TRACE to turn the TRACE_* macros on; without it
+ * they expand to nothing, or to the bare lock statement.
+ *
+ * Every thread appends to its own ring buffer, so recording an event is a
+ * timestamp read and a store into memory no other thread writes. When the
+ * ring is full the oldest events are overwritten. trace_write_chrome_json()
+ * dumps all rings for chrome://tracing or Perfetto; call it once the
+ * traced threads are quiet.
+ */
+
+inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct trace_event {
+	uint64_t timestamp;
+	// string literal, only the pointer is kept.
+	char const* name;
+	// 'B' begin, 'E' end, 'i' instant, as in the Chrome format.
+	char phase;
+};
+
+class trace_buffer {
+public:
+	static size_t const capacity = 1 << 16;
+
+	unsigned const tid;
+	atomic<uint64_t> written{0};
+	unique_ptr<trace_event[]> events;
+
+	explicit trace_buffer(unsigned tid_) : tid(tid_), events(new trace_event[capacity]) {}
+
+	void record(char const* name, char phase) {
+		uint64_t const index = written.load(memory_order_relaxed);
+		events[index & (capacity - 1)] = trace_event{trace_clock(), name, phase};
+		written.store(index + 1, memory_order_release);
+	}
+};
+
+class trace_registry {
+private:
+	mutex m_mutex;
+	vector<shared_ptr<trace_buffer>> m_buffers;
+	uint64_t const m_startTicks = trace_clock();
+	chrono::steady_clock::time_point const m_startTime = chrono::steady_clock::now();
+
+	trace_registry() {}
+
+public:
+	static trace_registry& instance() {
+		static trace_registry registry;
+		return registry;
+	}
+
+	// the registry keeps the ring alive after its thread has exited.
+	trace_buffer& local() {
+		static thread_local shared_ptr<trace_buffer> buffer;
+		if (!buffer) {
+			lock_guard<mutex> lock(m_mutex);
+			buffer = make_shared<trace_buffer>(m_buffers.size());
+			m_buffers.push_back(buffer);
+		}
+		return *buffer;
+	}
+
+	void write_chrome_json(ostream& out) {
+		// ticks to microseconds, measured over the lifetime of the registry.
+		double const elapsed_us = chrono::duration<double, micro>(chrono::steady_clock::now() - m_startTime).count();
+		double const ticks = double(trace_clock() - m_startTicks);
+		double const us_per_tick = ticks > 0 ? elapsed_us / ticks : 0;
+
+		lock_guard<mutex> lock(m_mutex);
+		ios::fmtflags const flags = out.flags();
+		out << "{\"traceEvents\": [";
+		bool first = true;
+		for (auto const& buffer : m_buffers) {
+			uint64_t const written = buffer->written.load(memory_order_acquire);
+			uint64_t const begin = written > trace_buffer::capacity ? written - trace_buffer::capacity : 0;
+			for (uint64_t i = begin; i < written; ++i) {
+				trace_event const& e = buffer->events[i & (trace_buffer::capacity - 1)];
+				out << (first ? "\n" : ",\n") << "{\"name\": \"" << e.name << "\", \"ph\": \"" << e.phase
+					<< "\", \"ts\": " << fixed << double(e.timestamp - m_startTicks) * us_per_tick
+					<< ", \"pid\": 1, \"tid\": " << buffer->tid;
+				if (e.phase == 'i') {
+					out << ", \"s\": \"t\"";
+				}
+				out << "}";
+				first = false;
+			}
+		}
+		out << "\n]}\n";
+		out.flags(flags);
+	}
+};
+
+inline void trace_record(char const* name, char phase) {
+	trace_registry::instance().local().record(name, phase);
+}
+
+inline bool trace_write_chrome_json(string const& path) {
+	ofstream out(path);
+	trace_registry::instance().write_chrome_json(out);
+	return bool(out);
+}
+
+class trace_scope {
+private:
+	char const* const m_name;
+public:
+	explicit trace_scope(char const* name) : m_name(name) {
+		trace_record(m_name, 'B');
+	}
+	trace_scope(trace_scope const&) = delete;
+	trace_scope& operator=(trace_scope const&) = delete;
+	~trace_scope() {
+		trace_record(m_name, 'E');
+	}
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if defined(PARALLEL_TRACE)
+#define TRACE_BEGIN(name) trace_record(name, 'B')
+#define TRACE_END(name) trace_record(name, 'E')
+#define TRACE_INSTANT(name) trace_record(name, 'i')
+#define TRACE_SCOPE(name) trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+/**
+ * Wraps a lock declaration: the wait shows as "lock wait" and the hold as
+ * "locked", which ends when the enclosing scope does.
+ * TRACE_LOCK(lock_guard<mutex> lock(m_mutex));
+ */
+#define TRACE_LOCK(...) \
+	TRACE_LOCK_WAIT(__VA_ARGS__); \
+	trace_scope TRACE_CONCAT(trace_locked_, __LINE__)("locked")
+/**
+ * Only the wait for the lock, for a unique_lock that is released before
+ * the scope ends, e.g. inside condition_variable::wait or an early unlock().
+ */
+#define TRACE_LOCK_WAIT(...) \
+	trace_record("lock wait", 'B'); \
+	__VA_ARGS__; \
+	trace_record("lock wait", 'E')
+#else
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_LOCK(...) __VA_ARGS__
+#define TRACE_LOCK_WAIT(...) __VA_ARGS__
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef BOUNDED_QUEUE
+#define BOUNDED_QUEUE
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+using namespace std;
+
+/**
+ * Blocking queue with a capacity: push waits while it is full,
+ * so a fast producer is held back to the pace of its consumer.
+ * close() lets the consumers drain what is left; abort() drops it
+ * and wakes everybody.
+ */
+template <typename T>
+class bounded_queue {
+private:
+	mutable mutex m_mutex;
+	condition_variable m_notEmpty;
+	condition_variable m_notFull;
+	deque<T> m_items;
+	size_t const m_capacity;
+	bool m_closed = false;
+	bool m_aborted = false;
+
+public:
+	explicit bounded_queue(size_t capacity) : m_capacity(capacity != 0 ? capacity : 1) {}
+	bounded_queue(bounded_queue const&) = delete;
+	bounded_queue& operator=(bounded_queue const&) = delete;
+
+	// false if the queue was closed or aborted, the value is then dropped.
+	bool push(T value) {
+		unique_lock<mutex> lock(m_mutex);
+		m_notFull.wait(lock, [this]() {
+			return m_items.size() < m_capacity || m_closed || m_aborted;
+		});
+		if (m_closed || m_aborted) {
+			return false;
+		}
+		m_items.push_back(move(value));
+		lock.unlock();
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	// nullopt once the queue is closed and drained, or aborted.
+	optional<T> pop() {
+		unique_lock<mutex> lock(m_mutex);
+		m_notEmpty.wait(lock, [this]() {
+			return !m_items.empty() || m_closed || m_aborted;
+		});
+		if (m_aborted || m_items.empty()) {
+			return nullopt;
+		}
+		optional<T> res(move(m_items.front()));
+		m_items.pop_front();
+		lock.unlock();
+		m_notFull.notify_one();
+		return res;
+	}
+
+	void close() {
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_closed = true;
+		}
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+	void abort() {
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_aborted = true;
+			m_items.clear();
+		}
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+	size_t size() const {
+		lock_guard<mutex> lock(m_mutex);
+		return m_items.size();
+	}
+};
+
+#endif
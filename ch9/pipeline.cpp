@@ -0,0 +1,64 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+	// read "lines", parse them in parallel, write them out in the original order.
+	int const lineCount = 2000;
+	int produced = 0;
+	atomic<int> inFlight{0}, peakInFlight{0};
+	long long checksum = 0;
+	bool ordered = true;
+	int expected = 0;
+
+	pipeline lines(8);
+	lines.source<string>([&]() -> optional<string> {
+		if (produced == lineCount) {
+			return nullopt;
+		}
+		int const now = ++inFlight;
+		int peak = peakInFlight.load();
+		while (now > peak && !peakInFlight.compare_exchange_weak(peak, now));
+		return to_string(produced++);
+	});
+	lines.stage<string>(stage_mode::parallel, [](string line) {
+		// uneven work, so items overtake each other.
+		int const value = stoi(line);
+		this_thread::sleep_for(chrono::microseconds(value % 7 * 20));
+		return value;
+	}, 4);
+	lines.stage<int>(stage_mode::serial_in_order, [&](int value) {
+		ordered = ordered && value == expected++;
+		checksum += value;
+		--inFlight;
+	});
+	lines.run();
+	cout << "checksum " << checksum << ", in order: " << boolalpha << ordered
+		<< ", peak in flight: " << peakInFlight << " (limit 8)" << endl;
+
+	// a throwing stage cancels the rest and comes out of run().
+	int next = 0;
+	pipeline failing(4);
+	failing.source<int>([&]() -> optional<int> {
+		return next++;
+	});
+	failing.stage<int>(stage_mode::serial_out_of_order, [](int value) {
+		if (value == 100) {
+			throw runtime_error("bad record 100");
+		}
+		return value;
+	});
+	failing.stage<int>(stage_mode::serial_out_of_order, [](int) {});
+	try {
+		failing.run();
+	} catch (exception const& e) {
+		cout << "caught: " << e.what() << endl;
+	}
+	return 0;
+}
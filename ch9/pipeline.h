@@ -0,0 +1,264 @@
+#ifndef PIPELINE
+#define PIPELINE
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
+#include "bounded_queue.h"
+#include "../ch8/join_threads.h"
+
+using namespace std;
+
+enum class stage_mode {
+	// one item at a time, in the order the source produced them.
+	serial_in_order,
+	// one item at a time, in whatever order they arrive.
+	serial_out_of_order,
+	// several items at once; the stage function must be thread safe.
+	parallel
+};
+
+/**
+ * A source followed by a chain of stages, each stage fed by a bounded
+ * queue from the one before. At most max_tokens items are in flight:
+ * the source waits for a token before producing and the last stage hands
+ * it back, so memory stays bounded however slow a stage is, and the
+ * throughput settles at that of the slowest stage.
+ *
+ * pipeline p(16);
+ * p.source<string>([&]() -> optional<string> { ... });
+ * p.stage<string>(stage_mode::parallel, [](string line) { return parse(line); });
+ * p.stage<record>(stage_mode::serial_in_order, [&](record r) { write(r); });
+ * p.run();
+ *
+ * If a stage throws, the pipeline is cancelled and run() rethrows it.
+ */
+class pipeline {
+private:
+	struct value_base {
+		virtual ~value_base() {}
+	};
+
+	template <typename T>
+	struct value_holder : value_base {
+		T value;
+		explicit value_holder(T&& value_) : value(move(value_)) {}
+	};
+
+	struct item {
+		unsigned long long sequence;
+		unique_ptr<value_base> value;
+	};
+
+	struct stage_info {
+		stage_mode mode;
+		unsigned width;
+		function<unique_ptr<value_base>(unique_ptr<value_base>)> func;
+		type_index input;
+		type_index output;
+	};
+
+	size_t const m_maxTokens;
+	size_t const m_queueCapacity;
+	function<unique_ptr<value_base>()> m_source;
+	type_index m_sourceType = typeid(void);
+	vector<stage_info> m_stages;
+
+	mutex m_mutex;
+	condition_variable m_tokenCv;
+	size_t m_tokens = 0;
+	bool m_cancelled = false;
+	exception_ptr m_error;
+	vector<unique_ptr<bounded_queue<item>>> m_queues;
+
+	bool acquireToken() {
+		unique_lock<mutex> lock(m_mutex);
+		m_tokenCv.wait(lock, [this]() {
+			return m_tokens > 0 || m_cancelled;
+		});
+		if (m_cancelled) {
+			return false;
+		}
+		--m_tokens;
+		return true;
+	}
+
+	void releaseToken() {
+		{
+			lock_guard<mutex> lock(m_mutex);
+			++m_tokens;
+		}
+		m_tokenCv.notify_one();
+	}
+
+	void fail(exception_ptr error) {
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (!m_error) {
+				m_error = error;
+			}
+			m_cancelled = true;
+		}
+		m_tokenCv.notify_all();
+		for (auto& queue : m_queues) {
+			queue->abort();
+		}
+	}
+
+	void process(size_t index, item& current) {
+		current.value = m_stages[index].func(move(current.value));
+		if (index + 1 < m_stages.size()) {
+			m_queues[index + 1]->push(move(current));
+		} else {
+			releaseToken();
+		}
+	}
+
+	void runStage(size_t index, atomic<unsigned>& running) {
+		bounded_queue<item>& input = *m_queues[index];
+		bool const inOrder = m_stages[index].mode == stage_mode::serial_in_order;
+		// items that arrived ahead of their turn; bounded by the token count.
+		map<unsigned long long, item> early;
+		unsigned long long next = 0;
+		try {
+			while (optional<item> current = input.pop()) {
+				if (!inOrder) {
+					process(index, *current);
+					continue;
+				}
+				early.emplace(current->sequence, move(*current));
+				for (auto it = early.find(next); it != early.end(); it = early.find(next)) {
+					process(index, it->second);
+					early.erase(it);
+					++next;
+				}
+			}
+		} catch (...) {
+			fail(current_exception());
+		}
+		if (--running == 0 && index + 1 < m_stages.size()) {
+			m_queues[index + 1]->close();
+		}
+	}
+
+	type_index lastType() const {
+		return m_stages.empty() ? m_sourceType : m_stages.back().output;
+	}
+
+public:
+	/**
+	 * queue_capacity bounds each inter-stage queue, by default
+	 * to max_tokens, which is as many items as can ever be waiting.
+	 */
+	explicit pipeline(size_t max_tokens, size_t queue_capacity = 0) :
+			m_maxTokens(max_tokens != 0 ? max_tokens : 1),
+			m_queueCapacity(queue_capacity != 0 ? queue_capacity : m_maxTokens) {}
+	pipeline(pipeline const&) = delete;
+	pipeline& operator=(pipeline const&) = delete;
+
+	// func returns the next item, or nullopt at the end of the input. It always runs serially.
+	template <typename T, typename Source>
+	pipeline& source(Source func) {
+		if (m_source) {
+			throw logic_error("pipeline already has a source");
+		}
+		m_source = [func = move(func)]() mutable -> unique_ptr<value_base> {
+			optional<T> next = func();
+			if (!next) {
+				return nullptr;
+			}
+			return unique_ptr<value_base>(new value_holder<T>(move(*next)));
+		};
+		m_sourceType = typeid(T);
+		return *this;
+	}
+
+	/**
+	 * func takes the previous stage's output as In and returns this stage's
+	 * output; a stage returning void ends the pipeline.
+	 * width is the thread count of a parallel stage.
+	 */
+	template <typename In, typename Function>
+	pipeline& stage(stage_mode mode, Function func, unsigned width = thread::hardware_concurrency()) {
+		typedef typename decay<typename invoke_result<Function&, In>::type>::type Out;
+		if (!m_source) {
+			throw logic_error("pipeline stage added before the source");
+		}
+		if (lastType() != type_index(typeid(In))) {
+			throw logic_error("pipeline stage input doesn't match the previous output");
+		}
+		stage_info info{mode, mode == stage_mode::parallel ? max(1u, width) : 1u, nullptr, typeid(In), typeid(Out)};
+		info.func = [func = move(func)](unique_ptr<value_base> value) mutable -> unique_ptr<value_base> {
+			In& input = static_cast<value_holder<In>*>(value.get())->value;
+			if constexpr (is_void<Out>::value) {
+				func(move(input));
+				return nullptr;
+			} else {
+				return unique_ptr<value_base>(new value_holder<Out>(func(move(input))));
+			}
+		};
+		m_stages.push_back(move(info));
+		return *this;
+	}
+
+	/**
+	 * Runs the source on the calling thread and every stage on threads
+	 * of its own until the source is exhausted and all items are through.
+	 * Can be run again afterwards if the source has more to give.
+	 */
+	void run() {
+		if (!m_source || m_stages.empty()) {
+			throw logic_error("pipeline needs a source and at least one stage");
+		}
+		m_tokens = m_maxTokens;
+		m_cancelled = false;
+		m_error = nullptr;
+		m_queues.clear();
+		for (size_t i = 0; i < m_stages.size(); ++i) {
+			m_queues.emplace_back(new bounded_queue<item>(m_queueCapacity));
+		}
+		unique_ptr<atomic<unsigned>[]> running(new atomic<unsigned>[m_stages.size()]);
+
+		vector<thread> threads;
+		{
+			join_threads joiner(threads);
+			joiner.place_caller();
+			try {
+				for (size_t i = 0; i < m_stages.size(); ++i) {
+					running[i] = m_stages[i].width;
+					for (unsigned w = 0; w < m_stages[i].width; ++w) {
+						threads.push_back(thread(&pipeline::runStage, this, i, ref(running[i])));
+						joiner.place(threads.size() - 1);
+					}
+				}
+				unsigned long long sequence = 0;
+				while (acquireToken()) {
+					unique_ptr<value_base> value = m_source();
+					if (!value) {
+						releaseToken();
+						break;
+					}
+					m_queues[0]->push(item{sequence++, move(value)});
+				}
+			} catch (...) {
+				fail(current_exception());
+			}
+			m_queues[0]->close();
+		}
+		if (m_error) {
+			rethrow_exception(m_error);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "task_graph.h"
+
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main() {
+	thread_pool pool(4);
+
+	// load two inputs, scale each one, then merge: the branches run side by side.
+	vector<int> left, right;
+	long long merged = 0;
+	task_graph graph;
+	auto loadLeft = graph.add([&]() {
+		left.assign(1000, 1);
+	});
+	auto loadRight = graph.add([&]() {
+		right.assign(2000, 1);
+	});
+	auto scaleLeft = graph.add([&]() {
+		for (int& value : left) {
+			value *= 2;
+		}
+	});
+	auto scaleRight = graph.add([&]() {
+		for (int& value : right) {
+			value *= 3;
+		}
+	});
+	auto merge = graph.add([&]() {
+		merged = accumulate(left.begin(), left.end(), 0LL) + accumulate(right.begin(), right.end(), 0LL);
+	});
+	graph.precede(loadLeft, scaleLeft);
+	graph.precede(loadRight, scaleRight);
+	graph.precede(scaleLeft, merge);
+	graph.precede(scaleRight, merge);
+	graph.run(pool).get();
+	cout << "merged: " << merged << endl;
+
+	// a failing stage skips everything after it.
+	bool ranAfterFailure = false;
+	task_graph failing;
+	auto broken = failing.add([]() {
+		throw runtime_error("stage failed");
+	});
+	auto after = failing.add([&]() {
+		ranAfterFailure = true;
+	});
+	failing.precede(broken, after);
+	try {
+		failing.run(pool).get();
+	} catch (exception const& e) {
+		cout << "caught: " << e.what() << ", later stage ran: " << boolalpha << ranAfterFailure << endl;
+	}
+	// the skipped stage's own result carries the same error.
+	try {
+		failing.result_of(after).get();
+	} catch (exception const& e) {
+		cout << "skipped stage: " << e.what() << endl;
+	}
+	return 0;
+}
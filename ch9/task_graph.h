@@ -0,0 +1,184 @@
+#ifndef TASK_GRAPH
+#define TASK_GRAPH
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "thread_pool.h"
+
+using namespace std;
+
+/**
+ * A DAG of tasks run on a thread_pool.
+ * Each node counts its unfinished predecessors; whoever finishes the last
+ * one posts the node, so no worker ever blocks on a future.get().
+ * If a node throws, everything downstream of it is skipped: the skipped
+ * nodes' results and the graph's future get the first exception.
+ * A graph runs once.
+ */
+class task_graph {
+private:
+	struct node {
+		function_wrapper task;
+		promise<void> finished;
+		shared_future<void> result;
+		vector<node*> successors;
+		size_t index = 0;
+		unsigned predecessors = 0;
+		atomic<unsigned> pending{0};
+		atomic<bool> cancelled{false};
+	};
+
+	vector<unique_ptr<node>> nodes;
+	thread_pool* pool = nullptr;
+	atomic<size_t> remaining{0};
+	atomic<bool> failed{false};
+	mutex error_mutex;
+	exception_ptr first_error;
+	promise<void> done;
+	bool started = false;
+
+	void recordFailure(exception_ptr error) {
+		lock_guard<mutex> lock(error_mutex);
+		if (!first_error) {
+			first_error = error;
+		}
+		failed = true;
+	}
+
+	exception_ptr firstError() {
+		lock_guard<mutex> lock(error_mutex);
+		return first_error;
+	}
+
+	void execute(node* n) {
+		bool const skip = n->cancelled.load();
+		if (skip) {
+			// the failure upstream was recorded before this node was cancelled.
+			n->finished.set_exception(firstError());
+		} else {
+			try {
+				n->task();
+				n->finished.set_value();
+			} catch (...) {
+				n->cancelled = true;
+				recordFailure(current_exception());
+				n->finished.set_exception(current_exception());
+			}
+		}
+		bool const cancel_successors = skip || n->cancelled.load();
+		for (node* successor : n->successors) {
+			if (cancel_successors) {
+				successor->cancelled = true;
+			}
+			if (--successor->pending == 0) {
+				pool->post([this, successor]() {
+					execute(successor);
+				});
+			}
+		}
+		if (--remaining == 0) {
+			if (failed.load()) {
+				done.set_exception(firstError());
+			} else {
+				done.set_value();
+			}
+		}
+	}
+
+	bool acyclic() const {
+		vector<unsigned> pending(nodes.size());
+		vector<node*> ready;
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			pending[i] = nodes[i]->predecessors;
+			if (pending[i] == 0) {
+				ready.push_back(nodes[i].get());
+			}
+		}
+		size_t visited = 0;
+		while (!ready.empty()) {
+			node* n = ready.back();
+			ready.pop_back();
+			++visited;
+			for (node* successor : n->successors) {
+				if (--pending[successor->index] == 0) {
+					ready.push_back(successor);
+				}
+			}
+		}
+		return visited == nodes.size();
+	}
+
+public:
+	typedef size_t node_id;
+
+	task_graph() {}
+	task_graph(task_graph const&) = delete;
+	task_graph& operator=(task_graph const&) = delete;
+
+	template <typename Function>
+	node_id add(Function func) {
+		if (started) {
+			throw logic_error("task_graph already started");
+		}
+		unique_ptr<node> n(new node);
+		n->task = function_wrapper(move(func));
+		n->result = n->finished.get_future().share();
+		n->index = nodes.size();
+		nodes.push_back(move(n));
+		return nodes.size() - 1;
+	}
+
+	// after runs once before has finished.
+	void precede(node_id before, node_id after) {
+		if (started) {
+			throw logic_error("task_graph already started");
+		}
+		nodes.at(before)->successors.push_back(nodes.at(after).get());
+		++nodes.at(after)->predecessors;
+	}
+
+	shared_future<void> result_of(node_id id) const {
+		return nodes.at(id)->result;
+	}
+
+	/**
+	 * Posts every node without predecessors and returns at once.
+	 * The graph must outlive the returned future becoming ready.
+	 */
+	future<void> run(thread_pool& workers) {
+		if (started) {
+			throw logic_error("task_graph already started");
+		}
+		if (!acyclic()) {
+			throw logic_error("task_graph has a cycle");
+		}
+		started = true;
+		pool = &workers;
+		future<void> res = done.get_future();
+		remaining = nodes.size();
+		if (nodes.empty()) {
+			done.set_value();
+			return res;
+		}
+		vector<node*> roots;
+		for (auto& n : nodes) {
+			n->pending = n->predecessors;
+			if (n->predecessors == 0) {
+				roots.push_back(n.get());
+			}
+		}
+		for (node* root : roots) {
+			pool->post([this, root]() {
+				execute(root);
+			});
+		}
+		return res;
+	}
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../ch4/threadSafeQueue.h"
+#include "../ch8/join_threads.h"
+
+using namespace std;
+
+/**
+ * std::function needs a copyable callable, packaged_task is move-only.
+ */
+class function_wrapper {
+private:
+	struct impl_base {
+		virtual void call() = 0;
+		virtual ~impl_base() {}
+	};
+
+	template <typename Function>
+	struct impl_type : impl_base {
+		Function func;
+		impl_type(Function&& f) : func(move(f)) {}
+		void call() { func(); }
+	};
+
+	unique_ptr<impl_base> impl;
+
+public:
+	function_wrapper() = default;
+
+	template <typename Function>
+	function_wrapper(Function&& func) :
+		impl(new impl_type<decay_t<Function>>(decay_t<Function>(forward<Function>(func)))) {}
+
+	function_wrapper(function_wrapper&& other) = default;
+	function_wrapper& operator=(function_wrapper&& other) = default;
+	function_wrapper(function_wrapper const&) = delete;
+	function_wrapper& operator=(function_wrapper const&) = delete;
+
+	explicit operator bool() const {
+		return impl != nullptr;
+	}
+
+	void operator()() {
+		impl->call();
+	}
+};
+
+/**
+ * Fixed set of workers fed from one ThreadSafeQueue.
+ * post() is fire-and-forget, submit() hands back a future.
+ * An empty task tells a worker to stop.
+ */
+class thread_pool {
+private:
+	ThreadSafeQueue<function_wrapper> work_queue;
+	vector<thread> threads;
+	join_threads joiner;
+
+	void worker_thread() {
+		while (function_wrapper task = work_queue.wait_pop()) {
+			task();
+		}
+	}
+
+public:
+	explicit thread_pool(unsigned thread_count = thread::hardware_concurrency()) : joiner(threads) {
+		if (thread_count == 0) {
+			thread_count = 2;
+		}
+		try {
+			for (unsigned i = 0; i < thread_count; ++i) {
+				threads.push_back(thread(&thread_pool::worker_thread, this));
+				joiner.place(i);
+			}
+		} catch (...) {
+			for (size_t i = 0; i < threads.size(); ++i) {
+				work_queue.push(function_wrapper());
+			}
+			throw;
+		}
+	}
+
+	~thread_pool() {
+		for (size_t i = 0; i < threads.size(); ++i) {
+			work_queue.push(function_wrapper());
+		}
+	}
+
+	thread_pool(thread_pool const&) = delete;
+	thread_pool& operator=(thread_pool const&) = delete;
+
+	unsigned size() const {
+		return threads.size();
+	}
+
+	template <typename Function>
+	void post(Function func) {
+		work_queue.push(function_wrapper(move(func)));
+	}
+
+	template <typename Function>
+	future<invoke_result_t<Function>> submit(Function func) {
+		typedef invoke_result_t<Function> result_type;
+		packaged_task<result_type()> task(move(func));
+		future<result_type> res(task.get_future());
+		work_queue.push(function_wrapper(move(task)));
+		return res;
+	}
+};
+
+#endif